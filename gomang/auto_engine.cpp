@@ -0,0 +1,426 @@
+#include "auto_engine.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include "benchmark.h"
+#include "core/engine_pool.h"
+#include "core/io_manifest.h"
+
+#ifdef ENABLE_IREE
+#	include "backends/iree/iree_engine.h"
+#endif
+
+#ifdef ENABLE_TENSORRT
+#	include "backends/trt/trt_engine.h"
+#endif
+
+#ifdef ENABLE_MNN
+#	include "backends/mnn/mnn_engine.h"
+#endif
+
+#ifdef ENABLE_NCNN
+#	include "backends/ncnn/ncnn_engine.h"
+#endif
+
+namespace gomang
+{
+namespace
+{
+struct Candidate
+{
+	std::string              backend;
+	std::vector<std::string> files;                     // model files, hashed into the cache key
+	bool                     uses_threads{true};        // false when the thread count has no effect
+
+	std::function<std::shared_ptr<IEngine>(unsigned int)> build;
+};
+
+bool filesExist(const std::vector<std::string> &files)
+{
+	return std::all_of(files.begin(), files.end(), [](const std::string &f) { return std::filesystem::exists(f); });
+}
+
+std::vector<Candidate> collectCandidates(const AutoEngineOptions &options)
+{
+	std::vector<Candidate>                  candidates;
+	const std::string                       base         = options.model_dir + "/";
+	[[maybe_unused]] const std::string     &name         = options.model_name;
+	[[maybe_unused]] const TensorDesc      &desc         = options.input_desc;
+	const EngineOptions                    &base_options = options.engine_options;
+
+	auto withThreads = [base_options](unsigned int threads) {
+		EngineOptions engine_options = base_options;
+		engine_options.num_threads   = threads;
+		return engine_options;
+	};
+
+#ifdef ENABLE_IREE
+	{
+		const std::string path = base + "iree/" + name + ".vmfb";
+		candidates.push_back({"iree", {path}, true, [path, desc, withThreads](unsigned int threads) {
+			                      return std::make_shared<IreeEngine>(path, desc, withThreads(threads));
+		                      }});
+	}
+#endif
+
+#ifdef ENABLE_TENSORRT
+	{
+		const std::string path = base + "trt/" + name + ".engine";
+		candidates.push_back({"TensorRT", {path}, false, [path, withThreads](unsigned int threads) {
+			                      return std::make_shared<TrtEngine>(path, withThreads(threads));
+		                      }});
+	}
+#endif
+
+#ifdef ENABLE_MNN
+	{
+		const std::string path = base + "mnn/" + name + ".mnn";
+		candidates.push_back({"MNN", {path}, true, [path, withThreads](unsigned int threads) {
+			                      return std::make_shared<MnnEngine>(path, withThreads(threads));
+		                      }});
+	}
+#endif
+
+#ifdef ENABLE_NCNN
+	{
+		const std::string stem = base + "ncnn/" + name + ".ncnn";
+		candidates.push_back({"ncnn", {stem + ".param", stem + ".bin"}, true, [stem, desc, withThreads](unsigned int threads) {
+			                      return std::make_shared<NcnnEngine>(stem, desc, withThreads(threads));
+		                      }});
+	}
+#endif
+
+	candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+	                                [](const Candidate &c) { return !filesExist(c.files); }),
+	                 candidates.end());
+	return candidates;
+}
+
+std::vector<unsigned int> getThreadCounts(const AutoEngineOptions &options)
+{
+	if (!options.thread_counts.empty())
+	{
+		return options.thread_counts;
+	}
+
+	const unsigned int        hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<unsigned int> counts;
+	for (unsigned int n = 1; n < hardware; n *= 2)
+	{
+		counts.push_back(n);
+	}
+	counts.push_back(hardware);
+	return counts;
+}
+
+// Model files are not part of the key: a hit only hashes the files of the
+// cached backend, which must still match the hash stored with it.
+std::string getCacheKey(const AutoEngineOptions &options)
+{
+	std::ostringstream key;
+	key << options.model_dir << '/' << options.model_name << '|';
+	for (size_t i = 0; i < options.input_desc.shape.size(); ++i)
+	{
+		key << (i ? "x" : "") << options.input_desc.shape[i];
+	}
+	key << '|' << (options.objective == TuneObjective::kLatency ? "latency" : "throughput") << '|'
+	    << AutoEngine::getCpuSignature();
+	return key.str();
+}
+
+std::string hashCandidateFiles(const Candidate &candidate)
+{
+	uint64_t hash = kModelHashSeed;
+	for (const auto &file : candidate.files)
+	{
+		hashModelFile(file, hash, hash);
+	}
+
+	std::ostringstream text;
+	text << std::hex << hash;
+	return text.str();
+}
+
+// Parses all of text; false for anything else instead of throwing.
+template <typename T>
+bool parseField(const std::string &text, T &value)
+{
+	const char *end         = text.data() + text.size();
+	const auto [ptr, error] = std::from_chars(text.data(), end, value);
+	return error == std::errc() && ptr == end;
+}
+
+// Cache lines are "<key>\t<backend>\t<threads>\t<score>\t<model hash>"; the
+// last line whose backend is still available with unchanged files wins.
+const Candidate *lookupCache(const std::string &path, const std::string &key,
+                             const std::vector<Candidate> &candidates, AutoEngineChoice &choice)
+{
+	std::ifstream                      in(path);
+	const Candidate                   *found = nullptr;
+	std::map<std::string, std::string> hashes;        // backend -> model hash, computed on first use
+	for (std::string line; std::getline(in, line);)
+	{
+		std::istringstream fields(line);
+		std::string        line_key;
+		std::string        backend;
+		std::string        threads;
+		std::string        score;
+		std::string        hash;
+		if (!std::getline(fields, line_key, '\t') || line_key != key || !std::getline(fields, backend, '\t') ||
+		    !std::getline(fields, threads, '\t') || !std::getline(fields, score, '\t') ||
+		    !std::getline(fields, hash, '\t'))
+		{
+			continue;
+		}
+
+		// A truncated or hand-edited line is a miss.
+		unsigned int num_threads = 0;
+		double       score_value = 0;
+		if (!parseField(threads, num_threads) || num_threads == 0 || !parseField(score, score_value))
+		{
+			continue;
+		}
+
+		auto candidate = std::find_if(candidates.begin(), candidates.end(),
+		                              [&backend](const Candidate &c) { return c.backend == backend; });
+		if (candidate == candidates.end())
+		{
+			continue;
+		}
+		auto [it, inserted] = hashes.try_emplace(backend);
+		if (inserted)
+		{
+			it->second = hashCandidateFiles(*candidate);
+		}
+		if (it->second != hash)
+		{
+			continue;
+		}
+
+		choice.backend     = backend;
+		choice.num_threads = num_threads;
+		choice.score       = score_value;
+		found              = &*candidate;
+	}
+	return found;
+}
+
+void storeCache(const std::string &path, const std::string &key, const AutoEngineChoice &choice,
+                const Candidate &candidate)
+{
+	// Appends are small enough to stay whole when several workers tune at once.
+	std::ofstream out(path, std::ios::app);
+	if (!out)
+	{
+		std::cerr << "AutoEngine: cannot write cache " << path << std::endl;
+		return;
+	}
+	out << key << '\t' << choice.backend << '\t' << choice.num_threads << '\t' << choice.score << '\t'
+	    << hashCandidateFiles(candidate) << '\n';
+}
+
+std::shared_ptr<IEngine> tryBuild(const Candidate &candidate, unsigned int num_threads)
+{
+	try
+	{
+		return candidate.build(num_threads);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "AutoEngine: " << candidate.backend << " with " << num_threads
+		          << " threads failed to build: " << e.what() << std::endl;
+		return nullptr;
+	}
+}
+
+// CPU backends get one replica per num_threads hardware threads; the others
+// (TensorRT) do not scale with host cores and run a single instance.
+size_t getReplicaCount(const Candidate &candidate, unsigned int num_threads)
+{
+	if (!candidate.uses_threads)
+	{
+		return 1;
+	}
+	const unsigned int hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	return std::max(hardware / std::max(num_threads, 1u), 1u);
+}
+
+// What kThroughput hands out and measures: replicas engines behind an
+// EnginePool, or engine itself when a single instance is enough.
+std::shared_ptr<IEngine> replicate(const Candidate &candidate, std::shared_ptr<IEngine> engine, unsigned int num_threads,
+                                   size_t &num_replicas)
+{
+	const size_t replicas = getReplicaCount(candidate, num_threads);
+	num_replicas          = 1;
+	if (replicas == 1)
+	{
+		return engine;
+	}
+
+	std::shared_ptr<EnginePool> pool;
+	try
+	{
+		pool = std::make_shared<EnginePool>(engine, replicas);
+	}
+	catch (const std::runtime_error &)
+	{
+		// No weight sharing: build the other replicas from scratch.
+		std::vector<std::shared_ptr<IEngine>> engines{engine};
+		while (engines.size() < replicas)
+		{
+			auto replica = tryBuild(candidate, num_threads);
+			if (!replica)
+			{
+				break;
+			}
+			engines.push_back(std::move(replica));
+		}
+		pool = std::make_shared<EnginePool>(std::move(engines));
+	}
+	num_replicas = pool->size();
+	return pool;
+}
+
+// Requests/s achieved with one closed-loop client per replica.
+double measureThroughput(const std::shared_ptr<IEngine> &engine, size_t num_replicas, const AutoEngineOptions &options)
+{
+	return Benchmark(engine)
+	    .runClosedLoop(static_cast<int>(num_replicas), options.throughput_duration, options.num_warmup)
+	    .achieved_rps;
+}
+
+bool isBetter(double score, double best, TuneObjective objective)
+{
+	return objective == TuneObjective::kLatency ? score < best : score > best;
+}
+}        // namespace
+
+std::shared_ptr<IEngine> AutoEngine::create(const AutoEngineOptions &options, AutoEngineChoice *choice)
+{
+	const auto candidates = collectCandidates(options);
+	if (candidates.empty())
+	{
+		std::cerr << "AutoEngine: no enabled backend has a model for " << options.model_name << std::endl;
+		return nullptr;
+	}
+
+	const std::string cache_path = options.cache_path.empty() ? options.model_dir + "/autotune.cache" : options.cache_path;
+	const std::string key        = getCacheKey(options);
+
+	AutoEngineChoice cached;
+	if (const Candidate *candidate = lookupCache(cache_path, key, candidates, cached))
+	{
+		if (auto engine = tryBuild(*candidate, cached.num_threads))
+		{
+			if (options.objective == TuneObjective::kThroughput)
+			{
+				engine = replicate(*candidate, std::move(engine), cached.num_threads, cached.num_replicas);
+			}
+			cached.from_cache = true;
+			if (choice)
+			{
+				*choice = cached;
+			}
+			return engine;
+		}
+	}
+
+	// The best engine so far stays alive, so the winner is not built twice.
+	std::shared_ptr<IEngine> best_engine;
+	AutoEngineChoice         best;
+	const Candidate         *best_candidate = nullptr;
+	for (const auto &candidate : candidates)
+	{
+		auto thread_counts = candidate.uses_threads ? getThreadCounts(options) : std::vector<unsigned int>{1};
+		for (unsigned int threads : thread_counts)
+		{
+			auto engine = tryBuild(candidate, threads);
+			if (!engine)
+			{
+				continue;
+			}
+
+			double score    = 0;
+			size_t replicas = 1;
+			if (options.objective == TuneObjective::kLatency)
+			{
+				const auto stats = Benchmark(engine).measure(options.num_warmup, options.num_infer);
+				score            = stats.p90_ms;
+				std::cout << "AutoEngine: " << candidate.backend << " x" << threads << " p90 " << stats.p90_ms
+				          << " ms, mean " << stats.mean_ms << " ms" << std::endl;
+			}
+			else
+			{
+				engine = replicate(candidate, std::move(engine), threads, replicas);
+				score  = measureThroughput(engine, replicas, options);
+				std::cout << "AutoEngine: " << candidate.backend << " x" << threads << " (" << replicas
+				          << " replicas) " << score << " req/s" << std::endl;
+			}
+
+			if (!best_engine || isBetter(score, best.score, options.objective))
+			{
+				best_engine       = std::move(engine);
+				best_candidate    = &candidate;
+				best.backend      = candidate.backend;
+				best.num_threads  = threads;
+				best.num_replicas = replicas;
+				best.score        = score;
+			}
+		}
+	}
+
+	if (!best_engine)
+	{
+		return nullptr;
+	}
+
+	std::cout << "AutoEngine: picked " << best.backend << " with " << best.num_threads << " threads";
+	if (best.num_replicas > 1)
+	{
+		std::cout << " x " << best.num_replicas << " replicas";
+	}
+	std::cout << std::endl;
+	storeCache(cache_path, key, best, *best_candidate);
+	if (choice)
+	{
+		*choice = best;
+	}
+	return best_engine;
+}
+
+std::string AutoEngine::getCpuSignature()
+{
+	std::string model = "unknown";
+
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	for (std::string line; std::getline(cpuinfo, line);)
+	{
+		if (line.rfind("model name", 0) == 0)
+		{
+			const size_t colon = line.find(':');
+			if (colon != std::string::npos && colon + 2 <= line.size())
+			{
+				model = line.substr(colon + 2);
+			}
+			break;
+		}
+	}
+
+	std::ostringstream signature;
+	signature << model << '/' << std::thread::hardware_concurrency();
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	signature << (__builtin_cpu_supports("avx2") ? "/avx2" : "") << (__builtin_cpu_supports("fma") ? "/fma" : "")
+	          << (__builtin_cpu_supports("f16c") ? "/f16c" : "") << (__builtin_cpu_supports("avx512f") ? "/avx512f" : "");
+#endif
+	return signature.str();
+}
+}        // namespace gomang
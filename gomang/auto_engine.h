@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/engine.h"
+#include "core/engine_options.h"
+
+namespace gomang
+{
+enum class TuneObjective
+{
+	kLatency,          // lowest p90 latency of a single engine
+	kThroughput        // most requests/s of one CPU replica per num_threads cores, returned as an EnginePool
+};
+
+struct AutoEngineOptions
+{
+	// Models are looked up as in the examples: <model_dir>/iree/<name>.vmfb,
+	// <model_dir>/mnn/<name>.mnn, <model_dir>/ncnn/<name>.ncnn.{param,bin}
+	// and <model_dir>/trt/<name>.engine. Backends not compiled in are skipped.
+	std::string model_name;
+	std::string model_dir{"models"};
+
+	TensorDesc input_desc;        // for backends that take the input shape from the caller
+
+	// Passed to every candidate; num_threads is replaced by the one being tried.
+	EngineOptions engine_options;
+
+	// Empty tries 1, 2, 4, ... up to the hardware thread count.
+	std::vector<unsigned int> thread_counts;
+
+	TuneObjective objective{TuneObjective::kLatency};
+	int           num_warmup{3};
+	int           num_infer{20};        // kLatency
+
+	// kThroughput: length of each closed-loop run.
+	std::chrono::milliseconds throughput_duration{1000};
+
+	// Decisions keyed by model, input shape, objective and CPU signature; a
+	// decision is reused only while its backend's model files hash the same.
+	// Empty uses <model_dir>/autotune.cache.
+	std::string cache_path;
+};
+
+struct AutoEngineChoice
+{
+	std::string  backend;
+	unsigned int num_threads{1};
+	size_t       num_replicas{1};        // engines behind the returned EnginePool when more than one
+	double       score{0};               // p90 ms for kLatency, measured requests/s for kThroughput
+	bool         from_cache{false};
+};
+
+// Picks the backend and thread count for a model on this machine. A cached
+// decision is built directly; otherwise every candidate is built and timed
+// with Benchmark, the best one is kept and the decision is appended to the
+// cache. For kThroughput the result is what was scored: an EnginePool of
+// num_replicas engines, which only reaches that rate under as many concurrent
+// requests. Returns nullptr if no candidate could be built.
+class AutoEngine
+{
+  public:
+	static std::shared_ptr<IEngine> create(const AutoEngineOptions &options, AutoEngineChoice *choice = nullptr);
+
+	// CPU model, hardware thread count and the SIMD extensions gomang dispatches
+	// on; hosts with the same signature share cache entries.
+	static std::string getCpuSignature();
+};
+}        // namespace gomang
@@ -1,13 +1,37 @@
 #include "iree_engine.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <sstream>
 
-#include "D_dncnn_color_blind.h"
-#include "SR_msrresnet_x4_psnr.h"
-#include "SR_edsr.h"
+#include "core/io_manifest.h"
+#include "core/trace.h"
+
+#ifdef GOMANG_IREE_EMBEDDED_MODULES
+#	include "D_dncnn_color_blind.h"
+#	include "SR_edsr.h"
+#	include "SR_msrresnet_x4_psnr.h"
+#endif
 
 namespace gomang
 {
+#ifdef GOMANG_IREE_EMBEDDED_MODULES
+namespace
+{
+// Modules compiled into the library, looked up by the model file's stem.
+struct EmbeddedModule
+{
+	const char *name;
+	const iree_file_toc_t *(*create)();
+};
+
+const EmbeddedModule kEmbeddedModules[] = {
+    {"D_dncnn_color_blind", D_dncnn_color_blind_create},
+    {"SR_edsr", SR_edsr_create},
+    {"SR_msrresnet_x4_psnr", SR_msrresnet_x4_psnr_create},
+};
+}        // namespace
+#endif
 
 inline iree_hal_buffer_params_t createBufferParams(
     iree_hal_buffer_usage_t  usage,
@@ -23,8 +47,10 @@ inline iree_hal_buffer_params_t createBufferParams(
 	return params;
 }
 
-IreeEngine::IreeEngine(std::string model_path, const TensorDesc &input_desc, unsigned int num_threads) :
-    IEngine(std::move(model_path), num_threads, "iree")
+IreeEngine::IreeEngine(std::string model_path, const TensorDesc &input_desc, unsigned int num_threads,
+                       IreeDeviceOptions device_options) :
+    IEngine(std::move(model_path), num_threads, "iree"),
+    device_options_(std::move(device_options))
 {
 	input_descs_.push_back(input_desc);
 	if (!initialize())
@@ -36,10 +62,39 @@ IreeEngine::IreeEngine(std::string model_path, const TensorDesc &input_desc, uns
 	{
 		throw std::runtime_error("Failed to detect output information");
 	}
+	markLoadPhase("output_info");
+}
+
+IreeEngine::IreeEngine(std::string model_path, const TensorDesc &input_desc, const EngineOptions &options,
+                       IreeDeviceOptions device_options) :
+    IreeEngine(std::move(model_path), input_desc, options.num_threads, std::move(device_options))
+{
+	host_allocator_ = options.host_allocator;
+	if (options.device == Device::kGPU)
+	{
+		std::cerr << "IreeEngine only builds local CPU devices; running on CPU" << std::endl;
+	}
 }
 
 IreeEngine::~IreeEngine()
 {
+	stopAsync();
+	// Every queued completion waits on its fence, so this drains the pipeline.
+	completion_queue_.reset();
+	for (auto *view : async_staging_)
+	{
+		iree_hal_buffer_view_release(view);
+	}
+	iree_hal_semaphore_release(timeline_);
+	if (input_list_)
+	{
+		iree_vm_list_release(input_list_);
+	}
+	if (output_list_)
+	{
+		iree_vm_list_release(output_list_);
+	}
+	iree_hal_buffer_view_release(input_view_);
 	iree_hal_device_release(device_);
 	iree_vm_context_release(context_);
 	iree_vm_instance_release(instance_);
@@ -53,6 +108,38 @@ bool IreeEngine::infer(const std::vector<const void *> &inputs, const std::vecto
 
 	return runInference(inputs[0], outputs[0], false);
 }
+bool IreeEngine::infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs)
+{
+	if (inputs.size() != 1 || outputs.size() != output_descs_.size())
+	{
+		std::cerr << "[iree] expected 1 input and " << output_descs_.size() << " outputs, got " << inputs.size()
+		          << " and " << outputs.size() << std::endl;
+		return false;
+	}
+
+	// runInference reads the whole result buffer into outputs[0], so the caller's
+	// tensor has to match it exactly; anything else is staged by the generic path.
+	auto matches = [](const ITensor &tensor, const TensorDesc &native) {
+		const auto &desc = tensor.desc();
+		return desc.data_type == native.data_type && desc.layout == native.layout &&
+		       desc.mem_type != MemoryType::kGPU && desc.shape == native.shape &&
+		       tensor.size() >= native.getByteSize();
+	};
+	if (!matches(*inputs[0], input_descs_[0]) || !matches(*outputs[0], output_descs_[0]))
+	{
+		return IEngine::infer(inputs, outputs);
+	}
+
+	iree_hal_buffer_view_t *input_buffer_view = importInputBuffer(inputs[0]->data());
+	if (!input_buffer_view)
+	{
+		return IEngine::infer(inputs, outputs);
+	}
+
+	bool ok = runInference(input_buffer_view, outputs[0]->data(), false);
+	iree_hal_buffer_view_release(input_buffer_view);
+	return ok;
+}
 std::vector<TensorDesc> IreeEngine::getInputInfo() const
 {
 	return input_descs_;
@@ -74,12 +161,19 @@ bool IreeEngine::initialize()
 	    instance_, 1, &device_, IREE_HAL_MODULE_FLAG_NONE,
 	    iree_hal_module_debug_sink_null(), iree_allocator_system(), &hal_module));
 
-	module_data_ = loadBytecodeModule();
+	IREE_CHECK_OK(createIoState());
+	markLoadPhase("device");
+
+	if (!loadBytecodeModule())
+	{
+		return false;
+	}
 
 	iree_vm_module_t *bytecode_module = nullptr;
 	IREE_CHECK_OK(iree_vm_bytecode_module_create(
 	    instance_, module_data_, iree_allocator_null(),
 	    iree_allocator_system(), &bytecode_module));
+	markLoadPhase("deserialize");
 
 	iree_vm_module_t *modules[] = {hal_module, bytecode_module};
 	IREE_CHECK_OK(iree_vm_context_create_with_modules(
@@ -94,84 +188,461 @@ bool IreeEngine::initialize()
 	IREE_CHECK_OK(iree_vm_context_resolve_function(
 	    context_, iree_make_cstring_view(kMainFunctionName), &main_function_));
 
+	const char    kAsyncFunctionName[] = "module.main_graph$async";
+	iree_status_t status               = iree_vm_context_resolve_function(
+        context_, iree_make_cstring_view(kAsyncFunctionName), &async_function_);
+	if (iree_status_is_ok(status))
+	{
+		IREE_CHECK_OK(createAsyncState());
+	}
+	else
+	{
+		iree_status_ignore(status);
+		async_function_ = {};
+	}
+	markLoadPhase("context");
+
 	return true;
 }
 iree_status_t IreeEngine::createDevice(iree_allocator_t host_allocator)
 {
-	// Register the local-task HAL driver
-	IREE_RETURN_IF_ERROR(iree_hal_local_task_driver_module_register(
-	    iree_hal_driver_registry_default()));
+	// Build the device directly instead of through the driver registry, so the
+	// executor topology is ours rather than the flag-driven default.
+	iree_hal_executable_loader_t *loaders[8]   = {nullptr};
+	iree_host_size_t              loader_count = 0;
+	IREE_RETURN_IF_ERROR(iree_hal_create_all_available_executable_loaders(
+	    /*plugin_manager=*/nullptr, IREE_ARRAYSIZE(loaders), &loader_count, loaders, host_allocator));
+
+	iree_hal_allocator_t *device_allocator = nullptr;
+	iree_status_t         status           = iree_hal_allocator_create_heap(
+        iree_make_cstring_view("local"), host_allocator, host_allocator, &device_allocator);
+
+	if (iree_status_is_ok(status) && device_options_.driver == IreeDeviceOptions::Driver::kLocalSync)
+	{
+		iree_hal_sync_device_params_t params;
+		iree_hal_sync_device_params_initialize(&params);
+		status = iree_hal_sync_device_create(
+		    iree_make_cstring_view("local-sync"), &params, loader_count, loaders,
+		    device_allocator, host_allocator, &device_);
+	}
+	else if (iree_status_is_ok(status))
+	{
+		iree_task_topology_t topology;
+		status = createTopology(&topology);
 
-	// Create driver
-	iree_hal_driver_t *driver     = nullptr;
-	iree_string_view_t identifier = iree_make_cstring_view("local-task");
-	iree_status_t      status     = iree_hal_driver_registry_try_create(
-        iree_hal_driver_registry_default(), identifier, host_allocator, &driver);
+		iree_task_executor_t *executor = nullptr;
+		if (iree_status_is_ok(status))
+		{
+			iree_task_executor_options_t options;
+			iree_task_executor_options_initialize(&options);
+			status = iree_task_executor_create(options, &topology, host_allocator, &executor);
+			iree_task_topology_deinitialize(&topology);
+		}
 
-	// Create default device
-	if (iree_status_is_ok(status))
-	{
-		status = iree_hal_driver_create_default_device(driver, host_allocator, &device_);
+		if (iree_status_is_ok(status))
+		{
+			iree_hal_task_device_params_t params;
+			iree_hal_task_device_params_initialize(&params);
+			status = iree_hal_task_device_create(
+			    iree_make_cstring_view("local-task"), &params, /*queue_count=*/1, &executor,
+			    loader_count, loaders, device_allocator, host_allocator, &device_);
+		}
+		iree_task_executor_release(executor);
 	}
 
-	iree_hal_driver_release(driver);
+	iree_hal_allocator_release(device_allocator);
+	for (iree_host_size_t i = 0; i < loader_count; ++i)
+	{
+		iree_hal_executable_loader_release(loaders[i]);
+	}
 	return status;
 }
-iree_const_byte_span_t IreeEngine::loadBytecodeModule()
+
+iree_status_t IreeEngine::createTopology(iree_task_topology_t *topology) const
 {
-	const struct iree_file_toc_t *module_file = D_dncnn_color_blind_create();
-	return iree_make_const_byte_span(module_file->data, module_file->size);
+	const auto &affinity = device_options_.cpu_affinity;
+
+	if (!affinity.empty())
+	{
+		const iree_host_size_t worker_count = num_threads_ ? num_threads_ : affinity.size();
+		iree_task_topology_initialize(topology);
+		for (iree_host_size_t i = 0; i < worker_count; ++i)
+		{
+			iree_task_topology_group_t group;
+			iree_task_topology_group_initialize(static_cast<uint8_t>(i), &group);
+			group.processor_index                 = static_cast<uint32_t>(affinity[i % affinity.size()]);
+			group.ideal_thread_affinity           = {};
+			group.ideal_thread_affinity.specified = 1;
+			group.ideal_thread_affinity.id        = static_cast<uint32_t>(affinity[i % affinity.size()]);
+			iree_status_t status                  = iree_task_topology_push_group(topology, &group);
+			if (!iree_status_is_ok(status))
+			{
+				iree_task_topology_deinitialize(topology);
+				return status;
+			}
+		}
+		return iree_ok_status();
+	}
+
+	if (device_options_.numa_node >= 0 || num_threads_ == 0)
+	{
+		const auto node = device_options_.numa_node >= 0 ? static_cast<iree_task_topology_node_id_t>(device_options_.numa_node)
+		                                                 : IREE_TASK_TOPOLOGY_NODE_ID_ANY;
+		return iree_task_topology_initialize_from_physical_cores(
+		    node, IREE_TASK_TOPOLOGY_PERFORMANCE_LEVEL_ANY,
+		    num_threads_ ? num_threads_ : IREE_TASK_EXECUTOR_MAX_WORKER_COUNT, topology);
+	}
+
+	iree_task_topology_initialize_from_group_count(num_threads_, topology);
+	return iree_ok_status();
 }
-bool IreeEngine::runInference(const void *input_data, void *output_data, bool detect_output)
+
+bool IreeEngine::loadBytecodeModule()
+{
+	// The mapping is handed to IREE as is (iree_allocator_null), so the module
+	// reads straight from the page cache instead of a heap copy.
+	if (module_file_.open(model_path_))
+	{
+		module_data_ = iree_make_const_byte_span(module_file_.data(), module_file_.size());
+		return true;
+	}
+
+#ifdef GOMANG_IREE_EMBEDDED_MODULES
+	const std::string stem = std::filesystem::path(model_path_).stem().string();
+	for (const auto &module : kEmbeddedModules)
+	{
+		if (stem == module.name)
+		{
+			const iree_file_toc_t *toc = module.create();
+			module_data_               = iree_make_const_byte_span(toc->data, toc->size);
+			std::cerr << "Using embedded IREE module " << module.name << std::endl;
+			return true;
+		}
+	}
+#endif
+
+	std::cerr << "Failed to load IREE module: " << module_file_.getError() << std::endl;
+	return false;
+}
+iree_status_t IreeEngine::createIoState()
 {
 	const auto &input_desc = input_descs_[0];
-	size_t      input_size = input_desc.calculateSize();
 
-	std::vector<iree_hal_dim_t> shape(input_desc.shape.size());
+	input_element_type_ = convertDataTypeToIree(input_desc.data_type);
+	if (input_element_type_ == IREE_HAL_ELEMENT_TYPE_NONE)
+	{
+		return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "unsupported input data type");
+	}
+
+	input_shape_.assign(input_desc.shape.begin(), input_desc.shape.end());
+	input_byte_length_ = input_desc.getElementsCount() * getDataTypeSize(input_desc.data_type);
+
+	IREE_RETURN_IF_ERROR(createStagingView(&input_view_));
+
+	IREE_RETURN_IF_ERROR(iree_vm_list_create(
+	    iree_vm_make_undefined_type_def(), 1, iree_allocator_system(), &input_list_));
+	return iree_vm_list_create(
+	    iree_vm_make_undefined_type_def(), 1, iree_allocator_system(), &output_list_);
+}
+
+iree_status_t IreeEngine::createStagingView(iree_hal_buffer_view_t **out_view)
+{
+	iree_hal_buffer_params_t params = createBufferParams(
+	    IREE_HAL_BUFFER_USAGE_DEFAULT | IREE_HAL_BUFFER_USAGE_MAPPING,
+	    IREE_HAL_MEMORY_ACCESS_ALL,
+	    IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE);
+
+	iree_hal_buffer_t *buffer = nullptr;
+	IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+	    iree_hal_device_allocator(device_), params, input_byte_length_, &buffer));
+	iree_status_t status = iree_hal_buffer_view_create(
+	    buffer, input_shape_.size(), input_shape_.data(), input_element_type_,
+	    IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, iree_allocator_system(), out_view);
+	iree_hal_buffer_release(buffer);
+	return status;
+}
+
+iree_status_t IreeEngine::createAsyncState()
+{
+	const unsigned int slots = std::max(device_options_.max_in_flight, 1u);
+	async_staging_.assign(slots, nullptr);
+	for (auto &view : async_staging_)
+	{
+		IREE_RETURN_IF_ERROR(createStagingView(&view));
+	}
+
+	completion_queue_ = std::make_unique<InferQueue>();
+	return iree_hal_semaphore_create(device_, timeline_value_, IREE_HAL_SEMAPHORE_FLAG_NONE, &timeline_);
+}
+
+void IreeEngine::inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs, InferCallback callback)
+{
+	if (!async_function_.module || inputs.empty() || outputs.empty())
+	{
+		IEngine::inferAsync(std::move(inputs), std::move(outputs), std::move(callback));
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(in_flight_mutex_);
+		in_flight_cv_.wait(lock, [this] { return in_flight_ < async_staging_.size(); });
+		++in_flight_;
+	}
+	auto finish = [this] {
+		std::lock_guard<std::mutex> lock(in_flight_mutex_);
+		--in_flight_;
+		in_flight_cv_.notify_one();
+	};
+
+	// Held across submission so timeline values and the completion FIFO agree.
+	std::lock_guard<std::mutex> lock(submit_mutex_);
+
+	iree_hal_fence_t *signal_fence   = nullptr;
+	iree_vm_list_t   *invoke_outputs = nullptr;
+	iree_status_t     status         = submitAsync(inputs[0], &signal_fence, &invoke_outputs);
+	if (!iree_status_is_ok(status))
+	{
+		iree_status_fprint(stderr, status);
+		iree_status_ignore(status);
+		finish();
+		if (callback)
+		{
+			callback(false);
+		}
+		return;
+	}
+
+	completion_queue_->submit([this, signal_fence, invoke_outputs, output = outputs[0], finish,
+	                           callback = std::move(callback)] {
+		bool ok = completeAsync(signal_fence, invoke_outputs, output);
+		finish();
+		if (callback)
+		{
+			callback(ok);
+		}
+	});
+}
+
+iree_status_t IreeEngine::submitAsync(const void *input_data, iree_hal_fence_t **out_signal_fence,
+                                      iree_vm_list_t **out_outputs)
+{
+	const uint64_t wait_value   = timeline_value_;
+	const uint64_t signal_value = wait_value + 1;
+
+	// At most async_staging_.size() requests are outstanding and they complete
+	// in order, so the slot last used max_in_flight requests ago is free again.
+	iree_hal_buffer_view_t *input_view = importInputBuffer(input_data);
+	if (!input_view)
+	{
+		GOMANG_TRACE_SCOPE("iree", "input_copy");
+		input_view = async_staging_[signal_value % async_staging_.size()];
+		iree_hal_buffer_view_retain(input_view);
+		iree_status_t status = iree_hal_buffer_map_write(
+		    iree_hal_buffer_view_buffer(input_view), 0, input_data, input_byte_length_);
+		if (!iree_status_is_ok(status))
+		{
+			iree_hal_buffer_view_release(input_view);
+			return status;
+		}
+	}
+
+	// Chaining on the previous request keeps compute in submission order; its
+	// upload above has already overlapped with that request's execution.
+	iree_hal_fence_t *wait_fence   = nullptr;
+	iree_hal_fence_t *signal_fence = nullptr;
+	iree_vm_list_t   *inputs       = nullptr;
+	iree_vm_list_t   *outputs      = nullptr;
+	iree_status_t     status       = iree_hal_fence_create_at(
+        timeline_, wait_value, iree_allocator_system(), &wait_fence);
+	if (iree_status_is_ok(status))
+	{
+		status = iree_hal_fence_create_at(timeline_, signal_value, iree_allocator_system(), &signal_fence);
+	}
+	if (iree_status_is_ok(status))
+	{
+		status = iree_vm_list_create(iree_vm_make_undefined_type_def(), 3, iree_allocator_system(), &inputs);
+	}
+	if (iree_status_is_ok(status))
+	{
+		iree_vm_ref_t ref = iree_hal_buffer_view_retain_ref(input_view);
+		status            = iree_vm_list_push_ref_move(inputs, &ref);
+	}
+	if (iree_status_is_ok(status))
+	{
+		iree_vm_ref_t ref = iree_hal_fence_retain_ref(wait_fence);
+		status            = iree_vm_list_push_ref_move(inputs, &ref);
+	}
+	if (iree_status_is_ok(status))
+	{
+		iree_vm_ref_t ref = iree_hal_fence_retain_ref(signal_fence);
+		status            = iree_vm_list_push_ref_move(inputs, &ref);
+	}
+	if (iree_status_is_ok(status))
+	{
+		status = iree_vm_list_create(iree_vm_make_undefined_type_def(), 1, iree_allocator_system(), &outputs);
+	}
+	if (iree_status_is_ok(status))
+	{
+		GOMANG_TRACE_SCOPE("iree", "iree_vm_invoke_async");
+		status = iree_vm_invoke(
+		    context_, async_function_, IREE_VM_INVOCATION_FLAG_NONE,
+		    nullptr, inputs, outputs, iree_allocator_system());
+	}
+
+	iree_hal_buffer_view_release(input_view);
+	if (inputs)
+	{
+		iree_vm_list_release(inputs);
+	}
+
+	if (!iree_status_is_ok(status))
+	{
+		// Nothing will signal this value now, so later requests need the host to
+		// advance the timeline. Signalling before the previous request reaches
+		// wait_value would mark its fence done while it still runs, so wait
+		// for it first.
+		if (wait_fence)
+		{
+			iree_status_ignore(iree_hal_fence_wait(wait_fence, iree_infinite_timeout()));
+			iree_status_ignore(iree_hal_semaphore_signal(timeline_, signal_value));
+			timeline_value_ = signal_value;
+		}
+		iree_hal_fence_release(wait_fence);
+		iree_hal_fence_release(signal_fence);
+		if (outputs)
+		{
+			iree_vm_list_release(outputs);
+		}
+		return status;
+	}
+
+	iree_hal_fence_release(wait_fence);
+
+	timeline_value_   = signal_value;
+	*out_signal_fence = signal_fence;
+	*out_outputs      = outputs;
+	return iree_ok_status();
+}
 
-	for (size_t i = 0; i < input_desc.shape.size(); i++)
+bool IreeEngine::completeAsync(iree_hal_fence_t *signal_fence, iree_vm_list_t *outputs, void *output_data)
+{
+	iree_status_t status;
 	{
-		shape[i] = static_cast<iree_hal_dim_t>(input_desc.shape[i]);
+		GOMANG_TRACE_SCOPE("iree", "fence_wait");
+		status = iree_hal_fence_wait(signal_fence, iree_infinite_timeout());
 	}
 
-	iree_hal_element_type_t element_type = convertDataTypeToIree(input_desc.data_type);
-	if (element_type == IREE_HAL_ELEMENT_TYPE_NONE)
+	if (iree_status_is_ok(status))
 	{
+		iree_hal_buffer_view_t *ret_buffer_view = iree_vm_list_get_buffer_view_assign(outputs, 0);
+		if (ret_buffer_view == nullptr)
+		{
+			status = iree_make_status(IREE_STATUS_NOT_FOUND, "async invocation returned no buffer view");
+		}
+		else if (!output_descs_.empty() &&
+		         iree_hal_buffer_view_byte_length(ret_buffer_view) > output_descs_[0].getByteSize())
+		{
+			status = iree_make_status(IREE_STATUS_OUT_OF_RANGE, "async result exceeds the declared output");
+		}
+		else if (output_data)
+		{
+			GOMANG_TRACE_SCOPE("iree", "output_copy");
+			status = iree_hal_buffer_map_read(iree_hal_buffer_view_buffer(ret_buffer_view), 0, output_data,
+			                                  iree_hal_buffer_view_byte_length(ret_buffer_view));
+		}
+	}
+
+	iree_hal_fence_release(signal_fence);
+	iree_vm_list_release(outputs);
+
+	if (!iree_status_is_ok(status))
+	{
+		iree_status_fprint(stderr, status);
+		iree_status_ignore(status);
 		return false;
 	}
+	return true;
+}
 
-	iree_hal_buffer_view_t *input_buffer_view = nullptr;
-	IREE_CHECK_OK(iree_hal_buffer_view_allocate_buffer_copy(
-	    device_, iree_hal_device_allocator(device_),
-	    input_desc.shape.size(), shape.data(), element_type,
-	    IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
-	    (iree_hal_buffer_params_t) {
-	        .usage = IREE_HAL_BUFFER_USAGE_DEFAULT,
-	        .type  = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
-	    },
-	    iree_make_const_byte_span(input_data, input_size),
-	    &input_buffer_view));
+bool IreeEngine::runInference(const void *input_data, void *output_data, bool detect_output)
+{
+	// Import the caller's memory when the allocator accepts it; otherwise copy
+	// into the persistent staging buffer.
+	if (iree_hal_buffer_view_t *imported = importInputBuffer(input_data))
+	{
+		bool ok = runInference(imported, output_data, detect_output);
+		iree_hal_buffer_view_release(imported);
+		return ok;
+	}
+
+	{
+		GOMANG_TRACE_SCOPE("iree", "input_copy");
+		IREE_CHECK_OK(iree_hal_buffer_map_write(
+		    iree_hal_buffer_view_buffer(input_view_), 0, input_data, input_byte_length_));
+	}
 
-	iree_vm_list_t *inputs = nullptr;
-	IREE_CHECK_OK(iree_vm_list_create(
-	    iree_vm_make_undefined_type_def(), 1, iree_allocator_system(), &inputs));
+	return runInference(input_view_, output_data, detect_output);
+}
+
+iree_hal_buffer_view_t *IreeEngine::importInputBuffer(const void *input_data)
+{
+	GOMANG_TRACE_SCOPE("iree", "input_import");
+
+	iree_hal_external_buffer_t external_buffer = {};
+	external_buffer.type                       = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION;
+	external_buffer.flags                      = IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE;
+	external_buffer.size                       = input_byte_length_;
+	external_buffer.handle.host_allocation.ptr = const_cast<void *>(input_data);
+
+	iree_hal_buffer_params_t params = createBufferParams(
+	    IREE_HAL_BUFFER_USAGE_DEFAULT,
+	    IREE_HAL_MEMORY_ACCESS_READ,
+	    IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE);
+
+	iree_hal_buffer_t *buffer = nullptr;
+	iree_status_t      status = iree_hal_allocator_import_buffer(
+        iree_hal_device_allocator(device_), params, &external_buffer,
+        iree_hal_buffer_release_callback_null(), &buffer);
+	if (!iree_status_is_ok(status))
+	{
+		iree_status_ignore(status);
+		return nullptr;
+	}
 
-	iree_vm_ref_t input_buffer_view_ref = iree_hal_buffer_view_move_ref(input_buffer_view);
-	IREE_CHECK_OK(iree_vm_list_push_ref_retain(inputs, &input_buffer_view_ref));
+	iree_hal_buffer_view_t *buffer_view = nullptr;
+	status                              = iree_hal_buffer_view_create(
+        buffer, input_shape_.size(), input_shape_.data(), input_element_type_,
+        IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, iree_allocator_system(), &buffer_view);
+	iree_hal_buffer_release(buffer);
+	if (!iree_status_is_ok(status))
+	{
+		iree_status_ignore(status);
+		return nullptr;
+	}
 
-	iree_vm_list_t *outputs = nullptr;
-	IREE_CHECK_OK(iree_vm_list_create(
-	    iree_vm_make_undefined_type_def(), 1, iree_allocator_system(), &outputs));
+	return buffer_view;
+}
 
-	IREE_CHECK_OK(iree_vm_invoke(
-	    context_, main_function_, IREE_VM_INVOCATION_FLAG_NONE,
-	    nullptr, inputs, outputs, iree_allocator_system()));
+bool IreeEngine::runInference(iree_hal_buffer_view_t *input_buffer_view, void *output_data, bool detect_output)
+{
+	const auto &input_desc = input_descs_[0];
 
-	iree_hal_buffer_view_t *ret_buffer_view = iree_vm_list_get_buffer_view_assign(outputs, 0);
+	// input_list_/output_list_ are reused across calls and left empty after each.
+	iree_vm_ref_t input_buffer_view_ref = iree_hal_buffer_view_retain_ref(input_buffer_view);
+	IREE_CHECK_OK(iree_vm_list_push_ref_move(input_list_, &input_buffer_view_ref));
+
+	{
+		GOMANG_TRACE_SCOPE("iree", "iree_vm_invoke");
+		IREE_CHECK_OK(iree_vm_invoke(
+		    context_, main_function_, IREE_VM_INVOCATION_FLAG_NONE,
+		    nullptr, input_list_, output_list_, iree_allocator_system()));
+	}
+
+	iree_hal_buffer_view_t *ret_buffer_view = iree_vm_list_get_buffer_view_assign(output_list_, 0);
 	if (ret_buffer_view == nullptr)
 	{
-		iree_vm_list_release(inputs);
-		iree_vm_list_release(outputs);
+		iree_vm_list_clear(input_list_);
+		iree_vm_list_clear(output_list_);
 		return false;
 	}
 
@@ -199,6 +670,9 @@ bool IreeEngine::runInference(const void *input_data, void *output_data, bool de
 			case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
 				output_desc.data_type = DataType::kFLOAT16;
 				break;
+			case IREE_HAL_ELEMENT_TYPE_BFLOAT_16:
+				output_desc.data_type = DataType::kBFLOAT16;
+				break;
 			case IREE_HAL_ELEMENT_TYPE_SINT_32:
 				output_desc.data_type = DataType::kINT32;
 				break;
@@ -221,19 +695,34 @@ bool IreeEngine::runInference(const void *input_data, void *output_data, bool de
 	}
 	else if (output_data)
 	{
-		// Copy data from device to host
-		const auto &output_desc = output_descs_[0];
-		size_t      output_size = output_desc.calculateSize();
-
-		IREE_CHECK_OK(iree_hal_device_transfer_d2h(
-		    device_, iree_hal_buffer_view_buffer(ret_buffer_view), 0,
-		    output_data, output_size, IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
-		    iree_infinite_timeout()));
+		// Local devices hand back host-visible memory, so a mapped read into the
+		// caller's buffer replaces the transfer submission.
+		GOMANG_TRACE_SCOPE("iree", "output_copy");
+		iree_hal_buffer_t  *buffer      = iree_hal_buffer_view_buffer(ret_buffer_view);
+		iree_device_size_t  output_size = iree_hal_buffer_view_byte_length(ret_buffer_view);
+		if (!output_descs_.empty() && output_size > output_descs_[0].getByteSize())
+		{
+			// Callers size their buffer from output_descs_; never write past it.
+			std::cerr << "[iree] result of " << output_size << " bytes exceeds the declared output" << std::endl;
+			iree_vm_list_clear(input_list_);
+			iree_vm_list_clear(output_list_);
+			return false;
+		}
+		if (iree_all_bits_set(iree_hal_buffer_memory_type(buffer), IREE_HAL_MEMORY_TYPE_HOST_VISIBLE))
+		{
+			IREE_CHECK_OK(iree_hal_buffer_map_read(buffer, 0, output_data, output_size));
+		}
+		else
+		{
+			IREE_CHECK_OK(iree_hal_device_transfer_d2h(
+			    device_, buffer, 0, output_data, output_size,
+			    IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout()));
+		}
 	}
 
-	// Clean up
-	iree_vm_list_release(inputs);
-	iree_vm_list_release(outputs);
+	// Release the caller's input and the output buffer now rather than on the next call.
+	iree_vm_list_clear(input_list_);
+	iree_vm_list_clear(output_list_);
 
 	return true;
 }
@@ -246,6 +735,8 @@ iree_hal_element_type_t IreeEngine::convertDataTypeToIree(DataType data_type) co
 			return IREE_HAL_ELEMENT_TYPE_FLOAT_32;
 		case DataType::kFLOAT16:
 			return IREE_HAL_ELEMENT_TYPE_FLOAT_16;
+		case DataType::kBFLOAT16:
+			return IREE_HAL_ELEMENT_TYPE_BFLOAT_16;
 		case DataType::kINT32:
 			return IREE_HAL_ELEMENT_TYPE_SINT_32;
 		case DataType::kINT8:
@@ -257,11 +748,101 @@ iree_hal_element_type_t IreeEngine::convertDataTypeToIree(DataType data_type) co
 
 bool IreeEngine::detectOutputInfo()
 {
+	// Static shapes in the function signature cost nothing to read; otherwise
+	// try the sidecar manifest before paying for a probe inference.
+	if (readDeclaredOutputInfo())
+	{
+		return true;
+	}
+
+	const uint64_t    model_hash    = hashModelBytes(module_data_.data, module_data_.data_length);
+	const std::string manifest_path = getIoManifestPath(model_path_);
+	if (loadIoManifest(manifest_path, model_hash, input_descs_, output_descs_))
+	{
+		return true;
+	}
+
 	const auto &input_desc = input_descs_[0];
 	size_t      input_size = input_desc.calculateSize();
 
 	std::vector<uint8_t> dummy_input(input_size, 0);
 
-	return runInference(dummy_input.data(), nullptr, true);
+	if (!runInference(dummy_input.data(), nullptr, true))
+	{
+		return false;
+	}
+	saveIoManifest(manifest_path, model_hash, input_descs_, output_descs_);
+	return true;
+}
+
+bool IreeEngine::readDeclaredOutputInfo()
+{
+	// e.g. "sync func @main_graph(%input0: tensor<1x3x64x64xf32>) -> (%output0: tensor<1x3x256x256xf32>)"
+	iree_string_view_t declaration = iree_vm_function_lookup_attr_by_name(
+	    &main_function_, iree_make_cstring_view("iree.abi.declaration"));
+	const std::string text(declaration.data, declaration.size);
+
+	const size_t results = text.find("->");
+	const size_t begin   = results == std::string::npos ? results : text.find("tensor<", results);
+	const size_t end     = begin == std::string::npos ? begin : text.find('>', begin);
+	if (end == std::string::npos)
+	{
+		return false;
+	}
+
+	// Dims and element type are 'x'-separated; dynamic dims ("?") need a probe.
+	std::vector<std::string> tokens;
+	std::istringstream       parts(text.substr(begin + 7, end - begin - 7));
+	for (std::string token; std::getline(parts, token, 'x');)
+	{
+		tokens.push_back(token);
+	}
+	if (tokens.size() < 2)
+	{
+		return false;
+	}
+
+	const auto &input_desc = input_descs_[0];
+	TensorDesc  output_desc;
+	const auto &element    = tokens.back();
+	if (element == "f32")
+	{
+		output_desc.data_type = DataType::kFLOAT32;
+	}
+	else if (element == "f16")
+	{
+		output_desc.data_type = DataType::kFLOAT16;
+	}
+	else if (element == "bf16")
+	{
+		output_desc.data_type = DataType::kBFLOAT16;
+	}
+	else if (element == "i32" || element == "si32")
+	{
+		output_desc.data_type = DataType::kINT32;
+	}
+	else if (element == "i8" || element == "si8")
+	{
+		output_desc.data_type = DataType::kINT8;
+	}
+	else
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i + 1 < tokens.size(); ++i)
+	{
+		if (tokens[i].empty() || tokens[i].find_first_not_of("0123456789") != std::string::npos)
+		{
+			return false;
+		}
+		output_desc.shape.push_back(std::stoll(tokens[i]));
+	}
+
+	output_desc.layout   = input_desc.layout;
+	output_desc.mem_type = input_desc.mem_type;
+	output_desc.name     = "output";
+	output_descs_.push_back(output_desc);
+	return true;
 }
 }        // namespace gomang
\ No newline at end of file
@@ -1,29 +1,86 @@
 #pragma once
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
-#include "iree/hal/drivers/local_task/registration/driver_module.h"
+#include "iree/hal/drivers/local_sync/sync_device.h"
+#include "iree/hal/drivers/local_task/task_device.h"
+#include "iree/hal/local/loaders/registration/init.h"
 #include "iree/modules/hal/module.h"
 #include "iree/vm/api.h"
+#include "iree/task/api.h"
 #include "iree/vm/bytecode/module.h"
 
 #include "core/engine.h"
+#include "core/engine_options.h"
+#include "core/mapped_file.h"
 
 namespace gomang
 {
+struct IreeDeviceOptions
+{
+	enum class Driver
+	{
+		kLocalTask,        // task executor with num_threads workers
+		kLocalSync         // runs inline on the calling thread, no worker hand-off
+	};
+
+	Driver driver{Driver::kLocalTask};
+
+	// CPU id per worker, reused round-robin when shorter than num_threads.
+	// Empty leaves placement to the OS (or to numa_node).
+	std::vector<int> cpu_affinity;
+
+	// Build the topology from the physical cores of this NUMA node; -1 for any.
+	// Ignored when cpu_affinity is set.
+	int numa_node{-1};
+
+	// Requests inferAsync keeps outstanding on modules exporting main_graph$async.
+	unsigned int max_in_flight{2};
+};
+
 class IreeEngine : public IEngine
 {
   public:
-	IreeEngine(std::string model_path, const TensorDesc& input_desc, unsigned int num_threads = 1);
+	// num_threads is the local-task worker count; 0 (the default, matching the
+	// driver's own default device) uses one worker per physical core.
+	IreeEngine(std::string model_path, const TensorDesc& input_desc, unsigned int num_threads = 0,
+	           IreeDeviceOptions device_options = {});
+
+	// Only num_threads applies: precision is fixed when the module is compiled
+	// and the engine always runs on the local CPU devices.
+	IreeEngine(std::string model_path, const TensorDesc& input_desc, const EngineOptions &options,
+	           IreeDeviceOptions device_options = {});
 	~IreeEngine() override;
+	using IEngine::infer;
+	using IEngine::inferAsync;
+
 	bool infer(
 	    const std::vector<const void *> &inputs,
 	    const std::vector<void *>       &outputs) override;
 
+	bool infer(
+	    const std::vector<const ITensor *> &inputs,
+	    const std::vector<ITensor *>       &outputs) override;
+
+	// With a module compiled for --iree-execution-model=async-external, each
+	// request is invoked through main_graph$async with a wait fence on the
+	// previous request and a signal fence of its own, so the call returns once
+	// the work is queued and the next input is staged while this one runs.
+	// Completion is awaited on a separate thread, which copies the output and
+	// runs the callback in submission order. Without that entry point this is
+	// the default worker-thread queue. Do not mix with concurrent infer() calls.
+	void inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs, InferCallback callback) override;
+
 	[[nodiscard]] std::vector<TensorDesc> getInputInfo() const override;
 	[[nodiscard]] std::vector<TensorDesc> getOutputInfo() const override;
 
   private:
+	IreeDeviceOptions device_options_;
+
 	iree_vm_instance_t* instance_{nullptr};
 	iree_hal_device_t* device_{nullptr};
 	iree_vm_context_t* context_{nullptr};
@@ -32,12 +89,39 @@ class IreeEngine : public IEngine
 	mutable std::vector<TensorDesc> input_descs_;
 	mutable std::vector<TensorDesc> output_descs_;
 
+	// Per-call state kept across runInference calls; one invocation at a time.
+	std::vector<iree_hal_dim_t> input_shape_;
+	iree_hal_element_type_t     input_element_type_{IREE_HAL_ELEMENT_TYPE_NONE};
+	iree_device_size_t          input_byte_length_{0};
+	iree_hal_buffer_view_t     *input_view_{nullptr};        // staging for inputs that cannot be imported
+	iree_vm_list_t             *input_list_{nullptr};
+	iree_vm_list_t             *output_list_{nullptr};
+
+	// Fence-chained submission state; async_function_.module is null when the
+	// module has no async entry point.
+	iree_vm_function_t                    async_function_{};
+	iree_hal_semaphore_t                 *timeline_{nullptr};
+	uint64_t                              timeline_value_{0};
+	std::vector<iree_hal_buffer_view_t *> async_staging_;        // one per in-flight slot
+	std::unique_ptr<InferQueue>           completion_queue_;
+	std::mutex                            submit_mutex_;
+	std::mutex                            in_flight_mutex_;
+	std::condition_variable               in_flight_cv_;
+	unsigned int                          in_flight_{0};
+
+	// Backing storage for module_data_ when loaded from model_path_; the
+	// bytecode module references it directly, so it must outlive context_.
+	MappedFile             module_file_;
 	iree_const_byte_span_t module_data_{};
 
 	bool initialize();
 
 	iree_status_t createDevice(iree_allocator_t host_allocator);
-	iree_const_byte_span_t loadBytecodeModule();
+	iree_status_t createTopology(iree_task_topology_t *topology) const;
+	iree_status_t createIoState();
+	iree_status_t createAsyncState();
+	iree_status_t createStagingView(iree_hal_buffer_view_t **out_view);
+	bool loadBytecodeModule();
 
 
 
@@ -45,8 +129,27 @@ class IreeEngine : public IEngine
 		      void* output_data,
 		      bool detect_output = false);
 
+	// Borrows input_buffer_view; the caller keeps its reference.
+	bool runInference(iree_hal_buffer_view_t* input_buffer_view,
+		      void* output_data,
+		      bool detect_output = false);
+
+	// Queues one invocation of async_function_; on success the caller owns the
+	// signal fence and the output list, which is only readable once it fires.
+	iree_status_t submitAsync(const void *input_data, iree_hal_fence_t **out_signal_fence,
+	                          iree_vm_list_t **out_outputs);
+	bool completeAsync(iree_hal_fence_t *signal_fence, iree_vm_list_t *outputs, void *output_data);
+
+	// Imports host memory as a device buffer without copying; nullptr when the
+	// device allocator refuses the import (e.g. misaligned pointer).
+	iree_hal_buffer_view_t* importInputBuffer(const void* input_data);
+
 	iree_hal_element_type_t convertDataTypeToIree(DataType data_type) const;
 
 	bool detectOutputInfo();
+
+	// Output shape from the iree.abi.declaration reflection attribute; false
+	// when it is absent or has dynamic dims.
+	bool readDeclaredOutputInfo();
 };
 }        // namespace gomang
\ No newline at end of file
@@ -1,20 +1,33 @@
 #include "mnn_engine.h"
 
+#include "core/layout.h"
+#include "core/trace.h"
+
 #include <chrono>
 #include <cstring>
 #include <iostream>
 
 namespace gomang
 {
-MnnEngine::MnnEngine(const std::string &model_path, unsigned int num_threads) :
-    IEngine(model_path, num_threads, "MNN")
+MnnEngine::MnnEngine(const std::string &model_path, unsigned int num_threads, Precision precision) :
+    MnnEngine(model_path, EngineOptions{.num_threads = num_threads, .precision = precision})
+{
+}
+
+MnnEngine::MnnEngine(const std::string &model_path, const EngineOptions &options) :
+    IEngine(model_path, options.num_threads, "MNN"),
+    options_(options)
 {
+	precision_      = options.precision;
+	host_allocator_ = options.host_allocator;
 	initHandler();
 
 	TensorDesc input_desc;
-	input_desc.shape     = {input_batch_, input_channel_, input_height_, input_width_};
+	input_desc.layout    = toMemoryLayout(dimension_type_);
+	input_desc.shape     = input_desc.layout == MemoryLayout::kNHWC ?
+	                           std::vector<int64_t>{input_batch_, input_height_, input_width_, input_channel_} :
+	                           std::vector<int64_t>{input_batch_, input_channel_, input_height_, input_width_};
 	input_desc.data_type = DataType::kFLOAT32;
-	input_desc.layout    = MemoryLayout::kNC4HW4;
 	input_desc.mem_type  = MemoryType::kCPU_PINNED;
 	input_desc.name      = "input";
 	input_info_.push_back(input_desc);
@@ -28,7 +41,7 @@ MnnEngine::MnnEngine(const std::string &model_path, unsigned int num_threads) :
 		auto       shape = tensor->shape();
 		desc.shape       = std::vector<int64_t>(shape.begin(), shape.end());
 		desc.data_type   = DataType::kFLOAT32;
-		desc.layout      = MemoryLayout::kNC4HW4;
+		desc.layout      = toMemoryLayout(tensor->getDimensionType());
 		desc.mem_type    = MemoryType::kCPU_PINNED;
 		desc.name        = it.first;
 
@@ -36,14 +49,40 @@ MnnEngine::MnnEngine(const std::string &model_path, unsigned int num_threads) :
 	}
 }
 
+MnnEngine::MnnEngine(const MnnEngine &source, std::shared_ptr<MNN::Interpreter> interpreter) :
+    IEngine(source.model_path_, source.num_threads_, "MNN"),
+    mnn_interpreter_(std::move(interpreter)),
+    options_(source.options_),
+    interpreter_mutex_(source.interpreter_mutex_),
+    input_info_(source.input_info_),
+    output_info_(source.output_info_)
+{
+	precision_      = source.precision_;
+	host_allocator_ = source.host_allocator_;
+	createSession();
+	markLoadPhase("session");
+}
+
 MnnEngine::~MnnEngine()
 {
-	mnn_interpreter_->releaseModel();
+	stopAsync();
+	// The model buffer stays with the Interpreter, which clones share, so that
+	// more sessions can still be created; it goes when the last owner does.
 	if (mnn_session_)
 	{
+		std::lock_guard<std::mutex> lock(*interpreter_mutex_);
 		mnn_interpreter_->releaseSession(mnn_session_);
 	}
 }
+
+std::shared_ptr<IEngine> MnnEngine::clone() const
+{
+	if (!mnn_interpreter_)
+	{
+		return nullptr;
+	}
+	return std::shared_ptr<MnnEngine>(new MnnEngine(*this, mnn_interpreter_));
+}
 bool MnnEngine::infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs)
 {
 	if (!mnn_interpreter_ || !mnn_session_)
@@ -51,19 +90,26 @@ bool MnnEngine::infer(const std::vector<const void *> &inputs, const std::vector
 		std::cerr << "MNN interpreter or session not initialized!" << std::endl;
 		return false;
 	}
-	if (void *inputPtr = input_tensor_->map(MNN::Tensor::MAP_TENSOR_WRITE, input_tensor_->getDimensionType()))
 	{
-		memcpy(inputPtr, inputs[0], input_info_[0].calculateSize());
-		input_tensor_->unmap(MNN::Tensor::MAP_TENSOR_WRITE, input_tensor_->getDimensionType(), inputPtr);
+		GOMANG_TRACE_SCOPE("mnn", "input_copy");
+		if (void *inputPtr = input_tensor_->map(MNN::Tensor::MAP_TENSOR_WRITE, input_tensor_->getDimensionType()))
+		{
+			memcpy(inputPtr, inputs[0], input_info_[0].calculateSize());
+			input_tensor_->unmap(MNN::Tensor::MAP_TENSOR_WRITE, input_tensor_->getDimensionType(), inputPtr);
+		}
+		else
+		{
+			std::cerr << "Failed to map input tensor!" << std::endl;
+			return false;
+		}
 	}
-	else
+
 	{
-		std::cerr << "Failed to map input tensor!" << std::endl;
-		return false;
+		GOMANG_TRACE_SCOPE("mnn", "runSession");
+		mnn_interpreter_->runSession(mnn_session_);
 	}
 
-	mnn_interpreter_->runSession(mnn_session_);
-
+	GOMANG_TRACE_SCOPE("mnn", "output_copy");
 	for (int i = 0; i < output_info_.size(); ++i)
 	{
 		auto tensor = mnn_interpreter_->getSessionOutput(mnn_session_, output_info_[i].name.c_str());
@@ -91,6 +137,73 @@ bool MnnEngine::infer(const std::vector<const void *> &inputs, const std::vector
 
 	return true;
 }
+bool MnnEngine::infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs)
+{
+	if (!mnn_interpreter_ || !mnn_session_)
+	{
+		std::cerr << "MNN interpreter or session not initialized!" << std::endl;
+		return false;
+	}
+	if (inputs.size() != 1 || outputs.size() != output_info_.size() ||
+	    !matchesNative(inputs[0]->desc(), input_info_[0]))
+	{
+		return IEngine::infer(inputs, outputs);
+	}
+	for (size_t i = 0; i < outputs.size(); ++i)
+	{
+		if (!matchesNative(outputs[i]->desc(), output_info_[i]))
+		{
+			return IEngine::infer(inputs, outputs);
+		}
+	}
+
+	// copyFromHostTensor/copyToHostTensor move data straight between the caller's
+	// buffers and backend memory, converting layout on the way, so there is no
+	// map()/memcpy staging copy in between.
+	auto host_input = wrapHostTensor(inputs[0]->desc(), const_cast<void *>(inputs[0]->data()));
+	if (!host_input)
+	{
+		return IEngine::infer(inputs, outputs);
+	}
+
+	std::vector<std::unique_ptr<MNN::Tensor>> host_outputs;
+	host_outputs.reserve(outputs.size());
+	for (auto *output : outputs)
+	{
+		host_outputs.push_back(wrapHostTensor(output->desc(), output->data()));
+		if (!host_outputs.back())
+		{
+			return IEngine::infer(inputs, outputs);
+		}
+	}
+
+	{
+		GOMANG_TRACE_SCOPE("mnn", "input_copy");
+		if (!input_tensor_->copyFromHostTensor(host_input.get()))
+		{
+			std::cerr << "Failed to copy input tensor!" << std::endl;
+			return false;
+		}
+	}
+
+	{
+		GOMANG_TRACE_SCOPE("mnn", "runSession");
+		mnn_interpreter_->runSession(mnn_session_);
+	}
+
+	GOMANG_TRACE_SCOPE("mnn", "output_copy");
+	for (int i = 0; i < output_info_.size(); ++i)
+	{
+		auto tensor = mnn_interpreter_->getSessionOutput(mnn_session_, output_info_[i].name.c_str());
+		if (!tensor->copyToHostTensor(host_outputs[i].get()))
+		{
+			std::cerr << "Failed to copy output tensor! [" << i << "]" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
 std::vector<TensorDesc> MnnEngine::getInputInfo() const
 {
 	return input_info_;
@@ -103,13 +216,58 @@ std::vector<TensorDesc> MnnEngine::getOutputInfo() const
 void MnnEngine::initHandler()
 {
 	mnn_interpreter_ = std::shared_ptr<MNN::Interpreter>(MNN::Interpreter::createFromFile(model_path_.c_str()));
+	markLoadPhase("deserialize");
+
+	createSession();
+	markLoadPhase("session");
+}
+
+void MnnEngine::createSession()
+{
+	std::lock_guard<std::mutex> lock(*interpreter_mutex_);
 
 	schedule_config_.numThread = static_cast<int>(num_threads_);
 	MNN::BackendConfig backend_config;
-	backend_config.precision       = MNN::BackendConfig::Precision_High;
-	backend_config.memory          = MNN::BackendConfig::Memory_High;
+	switch (precision_)
+	{
+		case Precision::kFP16:
+			backend_config.precision = MNN::BackendConfig::Precision_Low;
+			break;
+		case Precision::kBF16:
+			backend_config.precision = MNN::BackendConfig::Precision_Low_BF16;
+			break;
+		default:
+			backend_config.precision = MNN::BackendConfig::Precision_High;
+			break;
+	}
+	switch (options_.memory_mode)
+	{
+		case MemoryMode::kNormal:
+			backend_config.memory = MNN::BackendConfig::Memory_Normal;
+			break;
+		case MemoryMode::kLow:
+			backend_config.memory = MNN::BackendConfig::Memory_Low;
+			break;
+		default:
+			backend_config.memory = MNN::BackendConfig::Memory_High;
+			break;
+	}
+	switch (options_.power_mode)
+	{
+		case PowerMode::kHigh:
+			backend_config.power = MNN::BackendConfig::Power_High;
+			break;
+		case PowerMode::kLow:
+			backend_config.power = MNN::BackendConfig::Power_Low;
+			break;
+		default:
+			backend_config.power = MNN::BackendConfig::Power_Normal;
+			break;
+	}
 	schedule_config_.backendConfig = &backend_config;
-	schedule_config_.type          = MNN_FORWARD_CUDA;
+	// Unavailable GPU backends fall back to backupType.
+	schedule_config_.type       = options_.device == Device::kCPU ? MNN_FORWARD_CPU : MNN_FORWARD_CUDA;
+	schedule_config_.backupType = MNN_FORWARD_CPU;
 
 	mnn_session_ = mnn_interpreter_->createSession(schedule_config_);
 
@@ -139,4 +297,66 @@ void MnnEngine::initHandler()
 	}
 }
 
+std::unique_ptr<MNN::Tensor> MnnEngine::wrapHostTensor(const TensorDesc &desc, void *data)
+{
+	if (desc.mem_type == MemoryType::kGPU)
+	{
+		return nullptr;
+	}
+
+	halide_type_t type;
+	switch (desc.data_type)
+	{
+		case DataType::kFLOAT32:
+			type = halide_type_of<float>();
+			break;
+		case DataType::kINT32:
+			type = halide_type_of<int32_t>();
+			break;
+		case DataType::kINT8:
+			type = halide_type_of<int8_t>();
+			break;
+		default:
+			return nullptr;
+	}
+
+	MNN::Tensor::DimensionType dimension_type;
+	switch (desc.layout)
+	{
+		case MemoryLayout::kNCHW:
+			dimension_type = MNN::Tensor::CAFFE;
+			break;
+		case MemoryLayout::kNHWC:
+			dimension_type = MNN::Tensor::TENSORFLOW;
+			break;
+		case MemoryLayout::kNC4HW4:
+			dimension_type = MNN::Tensor::CAFFE_C4;
+			break;
+		default:
+			return nullptr;
+	}
+
+	std::vector<int> shape(desc.shape.begin(), desc.shape.end());
+	return std::unique_ptr<MNN::Tensor>(MNN::Tensor::create(shape, type, data, dimension_type));
+}
+
+bool MnnEngine::matchesNative(const TensorDesc &desc, const TensorDesc &native)
+{
+	return desc.data_type == native.data_type && desc.mem_type != MemoryType::kGPU &&
+	       withLayout(desc, native.layout).shape == native.shape;
+}
+
+MemoryLayout MnnEngine::toMemoryLayout(int dimension_type)
+{
+	switch (dimension_type)
+	{
+		case MNN::Tensor::TENSORFLOW:
+			return MemoryLayout::kNHWC;
+		case MNN::Tensor::CAFFE_C4:
+			return MemoryLayout::kNC4HW4;
+		default:
+			return MemoryLayout::kNCHW;
+	}
+}
+
 }        // namespace gomang
\ No newline at end of file
@@ -1,23 +1,37 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+
 #include <MNN/Interpreter.hpp>
 #include <MNN/MNNDefine.h>
 #include <MNN/Tensor.hpp>
-#include <MNN/ImageProcess.hpp>
 
 #include "core/engine.h"
+#include "core/engine_options.h"
 
 namespace gomang
 {
 class MnnEngine : public IEngine
 {
   public:
-	explicit MnnEngine(const std::string &_model_path, unsigned int _num_threads = 1);
+	explicit MnnEngine(const std::string &_model_path, unsigned int _num_threads = 1,
+	                   Precision precision = Precision::kFP32);
+
+	MnnEngine(const std::string &model_path, const EngineOptions &options);
 
 	~MnnEngine() override;
 
+	using IEngine::infer;
+
 	bool infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs) override;
 
+	bool infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs) override;
+
+	// Another Session on the same Interpreter: the parsed model is shared and
+	// the clone gets its own activation memory.
+	[[nodiscard]] std::shared_ptr<IEngine> clone() const override;
+
 	[[nodiscard]] std::vector<TensorDesc> getInputInfo() const override;
 	[[nodiscard]] std::vector<TensorDesc> getOutputInfo() const override;
 
@@ -26,9 +40,11 @@ class MnnEngine : public IEngine
 	MNN::Session                     *mnn_session_{nullptr};
 	MNN::Tensor                      *input_tensor_{nullptr};        // assume single input.
 	MNN::ScheduleConfig               schedule_config_;
-	std::shared_ptr<MNN::CV::ImageProcess> pretreat_; // init at subclass
+	EngineOptions                     options_;
+
+	// Session creation and release on a shared Interpreter are serialized.
+	std::shared_ptr<std::mutex> interpreter_mutex_{std::make_shared<std::mutex>()};
 
-	const unsigned int num_threads_{};        // initialize at runtime.
 	int                input_batch_{};
 	int                input_channel_{};
 	int                input_height_{};
@@ -39,6 +55,19 @@ class MnnEngine : public IEngine
 	std::vector<TensorDesc> output_info_;
 
   private:
+	MnnEngine(const MnnEngine &source, std::shared_ptr<MNN::Interpreter> interpreter);
+
 	void initHandler();
+	void createSession();
+
+	// Wraps caller memory in a host MNN::Tensor without copying; nullptr if the
+	// data type or memory type cannot be expressed that way.
+	[[nodiscard]] static std::unique_ptr<MNN::Tensor> wrapHostTensor(const TensorDesc &desc, void *data);
+
+	// True if a caller tensor holds the same elements as native in any layout
+	// MNN converts between, so copy{From,To}HostTensor moves the right extent.
+	[[nodiscard]] static bool matchesNative(const TensorDesc &desc, const TensorDesc &native);
+
+	[[nodiscard]] static MemoryLayout toMemoryLayout(int dimension_type);
 };
 }        // namespace gomang
@@ -1,20 +1,94 @@
 #include "ncnn_engine.h"
 
-#include <assert.h>
+#include <cstdint>
+#include <cstring>
+
+#include <ncnn/cpu.h>
+
+#include "core/io_manifest.h"
+#include "core/trace.h"
 
 namespace gomang
 {
-NcnnEngine::NcnnEngine(const std::string &model_path, const TensorDesc &input_desc, unsigned int num_threads) :
-    IEngine(model_path, num_threads, "ncnn"),
+namespace
+{
+// Mat channels start on 16-byte boundaries (cstep), so dense buffers are
+// copied plane by plane unless the padding happens to be zero.
+void copyToMat(const void *src, ncnn::Mat &dst)
+{
+	const size_t plane_bytes = static_cast<size_t>(dst.w) * dst.h * dst.d * dst.elemsize;
+	if (dst.cstep * dst.elemsize == plane_bytes)
+	{
+		memcpy(dst.data, src, plane_bytes * dst.c);
+		return;
+	}
+	for (int q = 0; q < dst.c; ++q)
+	{
+		memcpy(dst.channel(q).data, static_cast<const uint8_t *>(src) + q * plane_bytes, plane_bytes);
+	}
+}
+
+void copyFromMat(const ncnn::Mat &src, void *dst)
+{
+	const size_t plane_bytes = static_cast<size_t>(src.w) * src.h * src.d * src.elemsize;
+	if (src.cstep * src.elemsize == plane_bytes)
+	{
+		memcpy(dst, src.data, plane_bytes * src.c);
+		return;
+	}
+	for (int q = 0; q < src.c; ++q)
+	{
+		memcpy(static_cast<uint8_t *>(dst) + q * plane_bytes, src.channel(q).data, plane_bytes);
+	}
+}
+}        // namespace
+
+NcnnEngine::NcnnEngine(const std::string &model_path, const TensorDesc &input_desc, unsigned int num_threads,
+                       Precision precision) :
+    NcnnEngine(model_path, input_desc, EngineOptions{.num_threads = num_threads, .precision = precision})
+{
+}
+
+NcnnEngine::NcnnEngine(const std::string &model_path, const TensorDesc &input_desc, const EngineOptions &options) :
+    IEngine(model_path, options.num_threads, "ncnn"),
+    options_(options),
     param_path_(model_path + ".param"),
     bin_path_(model_path + ".bin")
 {
+	precision_      = options.precision;
+	host_allocator_ = options.host_allocator;
 	initHandler();
 
 	input_info_.push_back(input_desc);
 	input_name_         = net_->blobs()[net_->input_indexes()[0]].name;
 	input_info_.back().name = input_name_;
 
+	uint64_t          model_hash    = 0;
+	const std::string manifest_path = getIoManifestPath(model_path_);
+	const bool        hashed        = hashModelFile(param_path_, model_hash) &&
+	                                  hashModelFile(bin_path_, model_hash, model_hash);
+	if (hashed && loadIoManifest(manifest_path, model_hash, input_info_, output_info_))
+	{
+		for (const auto &desc : output_info_)
+		{
+			output_names_.push_back(desc.name);
+		}
+		markLoadPhase("output_info");
+		return;
+	}
+
+	detectOutputInfo(input_desc);
+	if (hashed)
+	{
+		saveIoManifest(manifest_path, model_hash, input_info_, output_info_);
+	}
+	markLoadPhase("output_info");
+}
+
+void NcnnEngine::detectOutputInfo(const TensorDesc &input_desc)
+{
+	// ncnn has no static shape inference, so the output shapes come from
+	// running the network once on zeros.
 	auto extrator = net_->create_extractor();
 
 	ncnn::Mat input = genInputMat(input_desc);
@@ -42,30 +116,144 @@ NcnnEngine::NcnnEngine(const std::string &model_path, const TensorDesc &input_de
 
 bool NcnnEngine::infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs)
 {
-	ncnn::Mat input = genInputMat(input_info_[0]);
-	memcpy(input.data, inputs[0], input_info_[0].calculateSize());
+	if (inputs.empty())
+	{
+		return false;
+	}
 
-	assert(output_names_.size() == outputs.size());
+	WorkerLease lease(*this);
+	auto       &state = *lease;
+	{
+		GOMANG_TRACE_SCOPE("ncnn", "input_copy");
+		if (state.input.empty())
+		{
+			state.input = genInputMat(input_info_[0]);
+		}
+		copyToMat(inputs[0], state.input);
+	}
 
-	auto extractor = net_->create_extractor();
-	extractor.set_light_mode(false);
+	return extractOutputs(state.input, outputs, state);
+}
 
-	extractor.input(input_name_.c_str(), input);
+bool NcnnEngine::infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs)
+{
+	if (inputs.size() != 1 || outputs.size() != output_names_.size())
+	{
+		std::cerr << "[ncnn] expected 1 input and " << output_names_.size() << " outputs, got " << inputs.size()
+		          << " and " << outputs.size() << std::endl;
+		return false;
+	}
+	if (!canWrapInput(inputs[0]->desc()))
+	{
+		return IEngine::infer(inputs, outputs);
+	}
+	for (size_t i = 0; i < outputs.size(); ++i)
+	{
+		if (!canWriteOutput(*outputs[i], output_info_[i]))
+		{
+			return IEngine::infer(inputs, outputs);
+		}
+	}
+
+	const auto &shape = input_info_[0].shape;
+	ncnn::Mat   input(static_cast<int>(shape[3]), static_cast<int>(shape[2]), static_cast<int>(shape[1]),
+	                  const_cast<void *>(inputs[0]->data()), sizeof(float));
 
-	for (int i=0;i<output_names_.size(); ++i)
+	std::vector<void *> output_ptrs;
+	output_ptrs.reserve(outputs.size());
+	for (auto *tensor : outputs)
 	{
-		ncnn::Mat output;
-		extractor.extract(output_names_[i].c_str(), output);
+		output_ptrs.push_back(tensor->data());
+	}
+
+	WorkerLease lease(*this);
+	return extractOutputs(input, output_ptrs, *lease);
+}
+
+NcnnEngine::NcnnEngine(const NcnnEngine &source, std::shared_ptr<ncnn::Net> net) :
+    IEngine(source.model_path_, source.num_threads_, "ncnn"),
+    net_(std::move(net)),
+    options_(source.options_),
+    param_path_(source.param_path_),
+    bin_path_(source.bin_path_),
+    input_name_(source.input_name_),
+    output_names_(source.output_names_),
+    input_info_(source.input_info_),
+    output_info_(source.output_info_)
+{
+	precision_      = source.precision_;
+	host_allocator_ = source.host_allocator_;
+}
+
+NcnnEngine::~NcnnEngine()
+{
+	stopAsync();
+}
+
+std::shared_ptr<IEngine> NcnnEngine::clone() const
+{
+	return std::shared_ptr<NcnnEngine>(new NcnnEngine(*this, net_));
+}
+
+NcnnEngine::HostAllocator::HostAllocator(IMemoryAllocator *upstream) :
+    upstream_(upstream)
+{
+}
+
+void *NcnnEngine::HostAllocator::fastMalloc(size_t size)
+{
+#ifdef NCNN_MALLOC_OVERREAD
+	return upstream_->allocate(size + NCNN_MALLOC_OVERREAD, MemoryType::kCPU);
+#else
+	return upstream_->allocate(size, MemoryType::kCPU);
+#endif
+}
+
+void NcnnEngine::HostAllocator::fastFree(void *ptr)
+{
+	upstream_->deallocate(ptr, MemoryType::kCPU);
+}
 
-		auto &desc = output_info_[i];
-		memcpy(outputs[i], output.data, desc.calculateSize());
+NcnnEngine::WorkerState::WorkerState(IMemoryAllocator *host_allocator) :
+    blob_allocator(&ncnn_blob_pool),
+    workspace_allocator(&ncnn_workspace_pool)
+{
+	if (host_allocator)
+	{
+		host_pool           = std::make_unique<PoolAllocator>(host_allocator);
+		host_adapter        = std::make_unique<HostAllocator>(host_pool.get());
+		blob_allocator      = host_adapter.get();
+		workspace_allocator = host_adapter.get();
 	}
+}
 
+NcnnEngine::WorkerLease::WorkerLease(NcnnEngine &engine) :
+    engine_(engine)
+{
+	std::lock_guard<std::mutex> lock(engine_.worker_mutex_);
+	if (engine_.free_worker_states_.empty())
+	{
+		engine_.worker_states_.push_back(std::make_unique<WorkerState>(engine_.host_allocator_.get()));
+		state_ = engine_.worker_states_.back().get();
+	}
+	else
+	{
+		// The most recently used state has the warmest pools.
+		state_ = engine_.free_worker_states_.back();
+		engine_.free_worker_states_.pop_back();
+	}
+}
 
-	return true;
+NcnnEngine::WorkerLease::~WorkerLease()
+{
+	std::lock_guard<std::mutex> lock(engine_.worker_mutex_);
+	engine_.free_worker_states_.push_back(state_);
 }
 
-NcnnEngine::~NcnnEngine() = default;
+NcnnEngine::WorkerState &NcnnEngine::WorkerLease::operator*() const
+{
+	return *state_;
+}
 
 std::vector<TensorDesc> NcnnEngine::getInputInfo() const
 {
@@ -79,13 +267,50 @@ std::vector<TensorDesc> NcnnEngine::getOutputInfo() const
 
 void NcnnEngine::initHandler()
 {
-	net_                          = std::make_unique<ncnn::Net>();
+	net_                          = std::make_shared<ncnn::Net>();
 	net_->opt.num_threads         = static_cast<int>(num_threads_);
-	net_->opt.use_vulkan_compute  = true;
+	net_->opt.use_vulkan_compute  = options_.device != Device::kCPU;
+
 	net_->opt.use_fp16_arithmetic = false;
 
+	// ncnn keeps fp32 at the blob boundary and casts internally, so only the
+	// storage between layers shrinks; arithmetic stays fp32. kFP32 keeps
+	// ncnn's own storage defaults.
+	if (precision_ == Precision::kFP16)
+	{
+		net_->opt.use_fp16_packed  = true;
+		net_->opt.use_fp16_storage = true;
+	}
+	else if (precision_ == Precision::kBF16)
+	{
+		// ncnn picks fp16 storage over bf16 when both are on.
+		net_->opt.use_fp16_packed  = false;
+		net_->opt.use_fp16_storage = false;
+		net_->opt.use_bf16_storage = true;
+	}
+
+	net_->opt.use_winograd_convolution = options_.use_winograd;
+	net_->opt.use_sgemm_convolution    = options_.use_sgemm;
+	net_->opt.use_packing_layout       = options_.use_packing;
+	net_->opt.lightmode                = options_.light_mode || options_.memory_mode == MemoryMode::kLow;
+
+	// set_cpu_powersave is process-wide, so the default leaves whatever another
+	// engine or the application chose alone.
+	switch (options_.power_mode)
+	{
+		case PowerMode::kHigh:
+			ncnn::set_cpu_powersave(2);
+			break;
+		case PowerMode::kLow:
+			ncnn::set_cpu_powersave(1);
+			break;
+		default:
+			break;
+	}
+
 	net_->load_param(param_path_.c_str());
 	net_->load_model(bin_path_.c_str());
+	markLoadPhase("deserialize");
 }
 
 ncnn::Mat NcnnEngine::genInputMat(TensorDesc tensor_desc) const
@@ -101,4 +326,65 @@ ncnn::Mat NcnnEngine::genInputMat(TensorDesc tensor_desc) const
 	return {};
 }
 
+bool NcnnEngine::canWrapInput(const TensorDesc &tensor_desc) const
+{
+	const auto &native = input_info_[0];
+	if (tensor_desc.layout != MemoryLayout::kNCHW || tensor_desc.data_type != DataType::kFLOAT32 ||
+	    tensor_desc.mem_type == MemoryType::kGPU || tensor_desc.shape != native.shape)
+	{
+		return false;
+	}
+
+	// ncnn aligns each channel to 16 bytes, so a dense NCHW buffer only lines up
+	// with Mat::cstep when the plane size is already a multiple of that.
+	size_t plane_bytes = tensor_desc.shape[2] * tensor_desc.shape[3] * sizeof(float);
+	return tensor_desc.shape[1] == 1 || plane_bytes % 16 == 0;
+}
+
+bool NcnnEngine::canWriteOutput(const ITensor &tensor, const TensorDesc &native)
+{
+	// copyFromMat writes dense FP32 NCHW, exactly what output_info_ describes.
+	const auto &desc = tensor.desc();
+	return desc.layout == native.layout && desc.data_type == native.data_type && desc.mem_type != MemoryType::kGPU &&
+	       desc.shape == native.shape && tensor.size() >= native.getByteSize();
+}
+
+bool NcnnEngine::extractOutputs(const ncnn::Mat &input, const std::vector<void *> &outputs, WorkerState &state)
+{
+	if (outputs.size() != output_names_.size())
+	{
+		std::cerr << "[ncnn] expected " << output_names_.size() << " outputs, got " << outputs.size() << std::endl;
+		return false;
+	}
+
+	auto extractor = net_->create_extractor();
+	extractor.set_blob_allocator(state.blob_allocator);
+	extractor.set_workspace_allocator(state.workspace_allocator);
+
+	// With a single output nothing but the final blob is ever read back, so
+	// intermediates can be recycled as soon as they are consumed. With several
+	// outputs a recycled blob may have to be recomputed for a later one. Light
+	// mode also lets in-place layers take over a consumed input, so it is kept
+	// off for external (caller-owned, refcount-less) input Mats.
+	const bool owns_input = input.refcount != nullptr;
+	extractor.set_light_mode(owns_input && (net_->opt.lightmode || output_names_.size() == 1));
+
+	extractor.input(input_name_.c_str(), input);
+
+	for (int i = 0; i < output_names_.size(); ++i)
+	{
+		ncnn::Mat output;
+		{
+			// ncnn runs the layers lazily, so extract() is where compute happens.
+			GOMANG_TRACE_SCOPE("ncnn", "extract");
+			extractor.extract(output_names_[i].c_str(), output);
+		}
+
+		GOMANG_TRACE_SCOPE("ncnn", "output_copy");
+		copyFromMat(output, outputs[i]);
+	}
+
+	return true;
+}
+
 }        // namespace gomang
\ No newline at end of file
@@ -1,26 +1,45 @@
 #pragma once
 
+#include <mutex>
+#include <vector>
+
+#include <ncnn/allocator.h>
 #include <ncnn/layer.h>
 #include <ncnn/net.h>
 
 #include "core/engine.h"
+#include "core/engine_options.h"
+#include "core/pool_allocator.h"
 
 namespace gomang
 {
 class NcnnEngine : public IEngine
 {
   public:
-	explicit NcnnEngine(const std::string &model_path,const TensorDesc& input_desc, unsigned int num_threads = 1);
+	explicit NcnnEngine(const std::string &model_path, const TensorDesc &input_desc, unsigned int num_threads = 1,
+	                    Precision precision = Precision::kFP32);
+
+	// power_mode is applied through ncnn::set_cpu_powersave, which is process-wide.
+	NcnnEngine(const std::string &model_path, const TensorDesc &input_desc, const EngineOptions &options);
 
 	~NcnnEngine() override;
 
+	using IEngine::infer;
+
 	bool infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs) override;
 
+	bool infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs) override;
+
+	// Shares the loaded Net; extractors and pooled blob memory stay per clone.
+	[[nodiscard]] std::shared_ptr<IEngine> clone() const override;
+
 	[[nodiscard]] std::vector<TensorDesc> getInputInfo() const override;
 	[[nodiscard]] std::vector<TensorDesc> getOutputInfo() const override;
 
   protected:
-	std::unique_ptr<ncnn::Net> net_{nullptr};
+	std::shared_ptr<ncnn::Net> net_{nullptr};        // read-only after load, shared with clones
+
+	EngineOptions options_;
 
 	std::string param_path_{};
 	std::string bin_path_{};
@@ -32,8 +51,78 @@ class NcnnEngine : public IEngine
 	std::vector<TensorDesc> output_info_;
 
   private:
+	// Serves ncnn blobs and workspaces from a gomang IMemoryAllocator, padded
+	// for the SIMD over-reads ncnn's own fastMalloc allows for.
+	class HostAllocator : public ncnn::Allocator
+	{
+	  public:
+		explicit HostAllocator(IMemoryAllocator *upstream);
+
+		void *fastMalloc(size_t size) override;
+		void  fastFree(void *ptr) override;
+
+	  private:
+		IMemoryAllocator *upstream_;
+	};
+
+	// Leased for one infer() call, so concurrent calls never share an unlocked
+	// pool; the pools keep blob and workspace memory across calls. There are
+	// only as many states as calls that ever ran at once, however many
+	// threads come and go. With
+	// EngineOptions::host_allocator set, both come from a PoolAllocator over it
+	// instead of ncnn's own pools.
+	struct WorkerState
+	{
+		explicit WorkerState(IMemoryAllocator *host_allocator);
+
+		ncnn::UnlockedPoolAllocator    ncnn_blob_pool;
+		ncnn::PoolAllocator            ncnn_workspace_pool;        // layers may allocate from several OpenMP threads
+		std::unique_ptr<PoolAllocator> host_pool;                  // locked, so it can serve both
+		std::unique_ptr<HostAllocator> host_adapter;
+
+		ncnn::Allocator *blob_allocator;
+		ncnn::Allocator *workspace_allocator;
+
+		ncnn::Mat input;        // reused staging for raw-pointer inputs
+	};
+
+	// Returns the state to the free list when the call finishes.
+	class WorkerLease
+	{
+	  public:
+		explicit WorkerLease(NcnnEngine &engine);
+		~WorkerLease();
+
+		WorkerLease(const WorkerLease &)            = delete;
+		WorkerLease &operator=(const WorkerLease &) = delete;
+
+		WorkerState &operator*() const;
+
+	  private:
+		NcnnEngine  &engine_;
+		WorkerState *state_;
+	};
+
+	std::mutex                                worker_mutex_;
+	std::vector<std::unique_ptr<WorkerState>> worker_states_;
+	std::vector<WorkerState *>                free_worker_states_;        // most recently used last
+
+	NcnnEngine(const NcnnEngine &source, std::shared_ptr<ncnn::Net> net);
+
+
 	void initHandler();
 
+	// Probe inference on zeros; used when no valid I/O manifest is cached.
+	void detectOutputInfo(const TensorDesc &input_desc);
+
 	[[nodiscard]] ncnn::Mat genInputMat(TensorDesc tensor_desc) const;
+
+	// True if the caller's buffer can back an external-data ncnn::Mat as is.
+	[[nodiscard]] bool canWrapInput(const TensorDesc &tensor_desc) const;
+
+	// True if copyFromMat can write straight into the caller's tensor.
+	static bool canWriteOutput(const ITensor &tensor, const TensorDesc &native);
+
+	bool extractOutputs(const ncnn::Mat &input, const std::vector<void *> &outputs, WorkerState &state);
 };
 }        // namespace gomang
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "trt_engine.h"
 
+#include "core/layout.h"
+#include "core/trace.h"
+
 #include <chrono>
+#include <cstdlib>
 #include <cuda_runtime.h>
 #include <fstream>
 #include <iostream>
@@ -27,7 +31,7 @@ void *TrtAllocator::allocate(size_t size, MemoryType type)
 	}
 	else
 	{
-		std::cerr << "Unsupported memory type" << std::endl;
+		ptr = std::aligned_alloc(64, (size + 63) & ~size_t{63});
 	}
 	return ptr;
 }
@@ -48,13 +52,21 @@ void TrtAllocator::deallocate(void *ptr, MemoryType type)
 }
 
 TrtEngine::TrtEngine(const std::string &model_path, unsigned int num_threads) :
-    IEngine(model_path, num_threads, "TensorRT")
+    TrtEngine(model_path, EngineOptions{.num_threads = num_threads})
 {
+}
+
+TrtEngine::TrtEngine(const std::string &model_path, const EngineOptions &options) :
+    IEngine(model_path, options.num_threads, "TensorRT")
+{
+	host_allocator_   = options.host_allocator;
+	device_allocator_ = options.device_allocator;
 	initHandler();
 }
 
 TrtEngine::~TrtEngine()
 {
+	stopAsync();
 	input_tensors_.clear();
 	output_tensors_.clear();
 	cudaStreamDestroy(stream_);
@@ -67,23 +79,31 @@ bool TrtEngine::infer(const std::vector<const void *> &inputs, const std::vector
 		return false;
 	}
 
-	for (size_t i = 0; i < inputs.size(); ++i)
 	{
-		size_t size = input_tensors_[i]->size();
-		cudaMemcpyAsync(input_tensors_[i]->data(), inputs[i], size,
-		                cudaMemcpyHostToDevice, stream_);
+		GOMANG_TRACE_SCOPE("trt", "input_copy");
+		for (size_t i = 0; i < inputs.size(); ++i)
+		{
+			size_t size = input_tensors_[i]->desc().getByteSize();
+			cudaMemcpyAsync(input_tensors_[i]->data(), inputs[i], size,
+			                cudaMemcpyHostToDevice, stream_);
+		}
+		cudaStreamSynchronize(stream_);
 	}
-	cudaStreamSynchronize(stream_);
 
-	if (!trt_context_->enqueueV3(stream_))
 	{
-		return false;
+		// Synchronize inside the scope so the span covers GPU execution, not just the enqueue.
+		GOMANG_TRACE_SCOPE("trt", "enqueueV3");
+		if (!trt_context_->enqueueV3(stream_))
+		{
+			return false;
+		}
+		cudaStreamSynchronize(stream_);
 	}
 
+	GOMANG_TRACE_SCOPE("trt", "output_copy");
 	for (size_t i = 0; i < outputs.size(); ++i)
 	{
-		cudaStreamSynchronize(stream_);
-		size_t size = output_tensors_[i]->size();
+		size_t size = output_tensors_[i]->desc().getByteSize();
 		cudaMemcpyAsync(outputs[i], output_tensors_[i]->data(), size,
 		                cudaMemcpyDeviceToHost, stream_);
 	}
@@ -92,6 +112,103 @@ bool TrtEngine::infer(const std::vector<const void *> &inputs, const std::vector
 	return true;
 }
 
+bool TrtEngine::infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs)
+{
+	if (!trt_context_ || inputs.size() != input_tensors_.size() ||
+	    outputs.size() != output_tensors_.size())
+	{
+		return false;
+	}
+
+	// GPU tensors are bound as they are, so they must match the binding exactly.
+	// Host tensors only need the binding's shape: a foreign layout or data type is
+	// converted by the generic path.
+	auto fits = [](const ITensor &tensor, const ITensor &native) {
+		const auto &desc        = tensor.desc();
+		const auto &native_desc = native.desc();
+		if (desc.mem_type == MemoryType::kGPU)
+		{
+			return desc.data_type == native_desc.data_type && desc.layout == native_desc.layout &&
+			       desc.shape == native_desc.shape && tensor.size() >= native_desc.getByteSize();
+		}
+		return withLayout(desc, native_desc.layout).shape == native_desc.shape && tensor.size() >= desc.getByteSize();
+	};
+	auto needs_conversion = [](const ITensor &tensor, const ITensor &native) {
+		return tensor.desc().mem_type != MemoryType::kGPU &&
+		       (tensor.desc().layout != native.desc().layout || tensor.desc().data_type != native.desc().data_type);
+	};
+
+	bool convert = false;
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		if (!fits(*inputs[i], *input_tensors_[i]))
+		{
+			std::cerr << "[trt] input " << i << " does not match binding " << input_tensors_[i]->desc().name << std::endl;
+			return false;
+		}
+		convert = convert || needs_conversion(*inputs[i], *input_tensors_[i]);
+	}
+	for (size_t i = 0; i < outputs.size(); ++i)
+	{
+		if (!fits(*outputs[i], *output_tensors_[i]))
+		{
+			std::cerr << "[trt] output " << i << " does not match binding " << output_tensors_[i]->desc().name << std::endl;
+			return false;
+		}
+		convert = convert || needs_conversion(*outputs[i], *output_tensors_[i]);
+	}
+	if (convert)
+	{
+		// Fails on any GPU tensor: the generic path only stages host memory.
+		return IEngine::infer(inputs, outputs);
+	}
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const char *name = input_tensors_[i]->desc().name.c_str();
+		if (inputs[i]->desc().mem_type == MemoryType::kGPU)
+		{
+			trt_context_->setTensorAddress(name, const_cast<void *>(inputs[i]->data()));
+		}
+		else
+		{
+			trt_context_->setTensorAddress(name, input_tensors_[i]->data());
+			cudaMemcpyAsync(input_tensors_[i]->data(), inputs[i]->data(), input_tensors_[i]->desc().getByteSize(),
+			                cudaMemcpyHostToDevice, stream_);
+		}
+	}
+
+	for (size_t i = 0; i < outputs.size(); ++i)
+	{
+		const char *name = output_tensors_[i]->desc().name.c_str();
+		trt_context_->setTensorAddress(name, outputs[i]->desc().mem_type == MemoryType::kGPU ? outputs[i]->data() : output_tensors_[i]->data());
+	}
+
+	bool ok = trt_context_->enqueueV3(stream_);
+
+	for (size_t i = 0; ok && i < outputs.size(); ++i)
+	{
+		if (outputs[i]->desc().mem_type != MemoryType::kGPU)
+		{
+			cudaMemcpyAsync(outputs[i]->data(), output_tensors_[i]->data(), output_tensors_[i]->desc().getByteSize(),
+			                cudaMemcpyDeviceToHost, stream_);
+		}
+	}
+	cudaStreamSynchronize(stream_);
+
+	// Restore the engine-owned bindings so the pointer overload keeps working.
+	for (const auto &tensor : input_tensors_)
+	{
+		trt_context_->setTensorAddress(tensor->desc().name.c_str(), tensor->data());
+	}
+	for (const auto &tensor : output_tensors_)
+	{
+		trt_context_->setTensorAddress(tensor->desc().name.c_str(), tensor->data());
+	}
+
+	return ok;
+}
+
 std::vector<TensorDesc> TrtEngine::getInputInfo() const
 {
 	std::vector<TensorDesc> res;
@@ -124,12 +241,31 @@ TensorDesc TrtEngine::createTensorDesc(const char *tensor_name, const nvinfer1::
 	}
 
 	desc.layout    = MemoryLayout::kNCHW;
-	desc.data_type = DataType::kFLOAT32;
+	desc.data_type = convertDataTypeFromTrt(trt_engine_->getTensorDataType(tensor_name));
 	desc.mem_type  = MemoryType::kGPU;
 
 	return desc;
 }
 
+DataType TrtEngine::convertDataTypeFromTrt(nvinfer1::DataType data_type)
+{
+	switch (data_type)
+	{
+		case nvinfer1::DataType::kHALF:
+			return DataType::kFLOAT16;
+#if NV_TENSORRT_MAJOR >= 9
+		case nvinfer1::DataType::kBF16:
+			return DataType::kBFLOAT16;
+#endif
+		case nvinfer1::DataType::kINT8:
+			return DataType::kINT8;
+		case nvinfer1::DataType::kINT32:
+			return DataType::kINT32;
+		default:
+			return DataType::kFLOAT32;
+	}
+}
+
 void TrtEngine::initHandler()
 {
 	// read engine file
@@ -146,6 +282,7 @@ void TrtEngine::initHandler()
 	std::vector<char> model_data(model_size);
 	file.read(model_data.data(), model_size);
 	file.close();
+	markLoadPhase("file_read");
 
 	trt_runtime_.reset(nvinfer1::createInferRuntime(trt_logger_));
 	// engine deserialize
@@ -155,6 +292,7 @@ void TrtEngine::initHandler()
 		std::cerr << "Failed to deserialize the TensorRT engine." << std::endl;
 		return;
 	}
+	markLoadPhase("deserialize");
 	trt_context_.reset(trt_engine_->createExecutionContext());
 	if (!trt_context_)
 	{
@@ -174,7 +312,7 @@ void TrtEngine::initHandler()
 		bool is_input = trt_engine_->getTensorIOMode(tensor_name) == nvinfer1::TensorIOMode::kINPUT;
 
 		TensorDesc desc     = createTensorDesc(tensor_name, tensor_dims, is_input);
-		auto       tensor   = std::make_shared<Tensor>(desc, &allocator_);
+		auto       tensor   = std::make_shared<Tensor>(desc, device_allocator_ ? device_allocator_.get() : &allocator_);
 		trt_context_->setTensorAddress(tensor_name, tensor->data());
 
 		if (is_input)
@@ -186,6 +324,7 @@ void TrtEngine::initHandler()
 			output_tensors_.push_back(tensor);
 		}
 	}
+	markLoadPhase("context");
 }
 
 }        // namespace gomang
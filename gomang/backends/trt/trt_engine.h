@@ -7,6 +7,7 @@
 #include <NvInfer.h>
 
 #include "core/engine.h"
+#include "core/engine_options.h"
 
 namespace gomang
 {
@@ -16,6 +17,8 @@ class Logger final : public nvinfer1::ILogger
 	void log(Severity severity, const char *msg) noexcept override;
 };
 
+// cudaMalloc for kGPU, cudaMallocHost for kCPU_PINNED and aligned_alloc for
+// kCPU, so one instance can sit under a TrackingAllocator for every type.
 class TrtAllocator : public IMemoryAllocator
 {
 public:
@@ -29,10 +32,20 @@ class TrtEngine : public IEngine
   public:
 	explicit TrtEngine(const std::string &trt_model_path, unsigned int num_threads = 1);
 
+	// Precision and tactics are baked into the serialized engine; only
+	// num_threads and the allocators are taken from options.
+	TrtEngine(const std::string &trt_model_path, const EngineOptions &options);
+
 	~TrtEngine() override;
 
+	using IEngine::infer;
+
 	bool infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs) override;
 
+	// Device-resident caller tensors are bound to the execution context directly;
+	// host tensors are still staged through the engine's own device buffers.
+	bool infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs) override;
+
 	[[nodiscard]] std::vector<TensorDesc> getInputInfo() const override;
 
 	[[nodiscard]] std::vector<TensorDesc> getOutputInfo() const override;
@@ -54,6 +67,8 @@ class TrtEngine : public IEngine
 	void initHandler();
 	TensorDesc createTensorDesc(const char* tensor_name, const nvinfer1::Dims& dims, bool is_input);
 
+	static DataType convertDataTypeFromTrt(nvinfer1::DataType data_type);
+
 
 };
 }        // namespace gomang
@@ -1,5 +1,17 @@
 #include "benchmark.h"
 
+#include "core/precision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <thread>
+
 namespace gomang
 {
 
@@ -39,55 +51,461 @@ void printSimpleOutputCheck(const std::vector<std::vector<float>>& output_buffer
 
 	std::cout << "===================" << std::endl;
 }
+
+bool isReducedFloat(DataType type)
+{
+	return type == DataType::kFLOAT16 || type == DataType::kBFLOAT16;
+}
 }
 
-void Benchmark::run(int num_warmup, int num_infer) const
+LatencyStats Benchmark::run(int num_warmup, int num_infer) const
 {
-	std::cout << std::endl
-			  << "[[" << engine_->getName() << "]]:" << std::endl;
-	engine_->printTensorInfo();
+	auto buffers = prepare(num_warmup);
+
+	std::cout << "Benchmarking..." << std::endl;
+	std::vector<double> samples;
+	samples.reserve(num_infer);
+	for (int i = 0; i < num_infer; ++i)
+	{
+		samples.push_back(timeInference(buffers));
+	}
+
+	auto stats = LatencyStats::compute(std::move(samples));
+	report(buffers, stats);
+	return stats;
+}
+
+LatencyStats Benchmark::measure(int num_warmup, int num_infer) const
+{
+	auto buffers = allocateBuffers();
+	for (int i = 0; i < num_warmup; ++i)
+	{
+		engine_->infer(buffers.inputs, buffers.outputs);
+	}
+
+	std::vector<double> samples;
+	samples.reserve(num_infer);
+	for (int i = 0; i < num_infer; ++i)
+	{
+		samples.push_back(timeInference(buffers));
+	}
+	return LatencyStats::compute(std::move(samples));
+}
+
+LatencyStats Benchmark::runAdaptive(int num_warmup, double target_ci_ratio, int min_infer, int max_infer) const
+{
+	auto buffers = prepare(num_warmup);
+
+	std::cout << "Benchmarking until 95% CI < " << target_ci_ratio * 100.0 << "% of mean..." << std::endl;
+	std::vector<double> samples;
+
+	// Welford's running mean/variance keeps the stopping check O(1).
+	double mean = 0.0;
+	double m2   = 0.0;
+	for (int i = 0; i < max_infer; ++i)
+	{
+		double sample = timeInference(buffers);
+		samples.push_back(sample);
+
+		double delta = sample - mean;
+		mean += delta / static_cast<double>(samples.size());
+		m2 += delta * (sample - mean);
+
+		if (static_cast<int>(samples.size()) >= min_infer)
+		{
+			double n          = static_cast<double>(samples.size());
+			double half_width = 1.96 * std::sqrt(m2 / (n - 1) / n);
+			if (half_width <= target_ci_ratio * mean)
+			{
+				break;
+			}
+		}
+	}
+
+	auto stats = LatencyStats::compute(std::move(samples));
+	report(buffers, stats);
+	return stats;
+}
+
+void printLoadCurve(const std::vector<LoadPoint> &points)
+{
+	auto flags     = std::cout.flags();
+	auto precision = std::cout.precision();
+
+	std::cout << "=== Throughput vs. Latency ===" << std::endl;
+	std::cout << std::setw(8) << "clients" << std::setw(12) << "offered/s" << std::setw(12) << "achieved/s"
+	          << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms"
+	          << std::setw(10) << "max ms" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (const auto &point : points)
+	{
+		std::cout << std::setw(8) << point.concurrency << std::setw(12) << point.offered_rps
+		          << std::setw(12) << point.achieved_rps << std::setw(10) << point.latency.p50_ms
+		          << std::setw(10) << point.latency.p90_ms << std::setw(10) << point.latency.p99_ms
+		          << std::setw(10) << point.latency.max_ms << std::endl;
+	}
+	std::cout << "==============================" << std::endl;
+
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+}
+
+void ColdStartProfile::print() const
+{
+	auto flags     = std::cout.flags();
+	auto precision = std::cout.precision();
+
+	constexpr double kMiB = 1024.0 * 1024.0;
+	std::cout << "=== Cold Start: " << engine_name << " ===" << std::endl;
+	std::cout << std::setw(18) << "phase" << std::setw(12) << "ms" << std::setw(12) << "rss MiB"
+	          << std::setw(12) << "+rss MiB" << std::setw(12) << "peak MiB" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (const auto &phase : phases)
+	{
+		const double added = (static_cast<double>(phase.memory.rss_bytes) - static_cast<double>(baseline.rss_bytes)) / kMiB;
+		std::cout << std::setw(18) << phase.name << std::setw(12) << phase.duration_ms
+		          << std::setw(12) << phase.memory.rss_bytes / kMiB << std::setw(12) << added
+		          << std::setw(12) << phase.memory.peak_rss_bytes / kMiB << std::endl;
+	}
+	std::cout << "Construction: " << construct_ms << " ms | Baseline RSS: " << baseline.rss_bytes / kMiB << " MiB"
+	          << std::endl;
+	std::cout << "==============================" << std::endl;
+
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+
+	if (allocator_stats)
+	{
+		allocator_stats->print();
+	}
+}
+
+std::optional<AllocatorStats> getAllocatorStats(const IEngine &engine)
+{
+	const auto *host   = dynamic_cast<const TrackingAllocator *>(engine.getHostAllocator());
+	const auto *device = dynamic_cast<const TrackingAllocator *>(engine.getDeviceAllocator());
+	if (!host && !device)
+	{
+		return std::nullopt;
+	}
+
+	AllocatorStats stats = host ? host->getStats() : device->getStats();
+	if (host && device && host != device)
+	{
+		stats.merge(device->getStats());
+	}
+	return stats;
+}
+
+ColdStartProfile Benchmark::profileColdStart(const std::function<std::shared_ptr<IEngine>()> &create, int num_infer)
+{
+	using Clock = std::chrono::steady_clock;
+
+	ColdStartProfile profile;
+	profile.baseline = readProcessMemory();
+
+	const auto start  = Clock::now();
+	auto       engine = create();
+
+	profile.construct_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	profile.engine_name = engine->getName();
+	profile.phases      = engine->getLoadPhases();
+
+	// Whatever the backend did not attribute to a marked phase.
+	double marked_ms = 0;
+	for (const auto &phase : profile.phases)
+	{
+		marked_ms += phase.duration_ms;
+	}
+	if (profile.construct_ms > marked_ms)
+	{
+		profile.phases.push_back({"construct_other", profile.construct_ms - marked_ms, readProcessMemory()});
+	}
+
+	Benchmark bench(engine);
+	auto      buffers = bench.allocateBuffers();
+
+	profile.phases.push_back({"first_inference", bench.timeInference(buffers), readProcessMemory()});
+
+	std::vector<double> samples;
+	samples.reserve(num_infer);
+	for (int i = 0; i < num_infer; ++i)
+	{
+		samples.push_back(bench.timeInference(buffers));
+	}
+	profile.steady_state = LatencyStats::compute(std::move(samples));
+	profile.phases.push_back({"steady_state", profile.steady_state.mean_ms, readProcessMemory()});
+	profile.allocator_stats = getAllocatorStats(*engine);
+
+	profile.print();
+	return profile;
+}
+
+LoadPoint Benchmark::runClosedLoop(int num_clients, std::chrono::milliseconds duration, int num_warmup) const
+{
+	prepare(num_warmup);
+	std::cout << "Closed loop with " << num_clients << " clients for " << duration.count() << " ms..." << std::endl;
+
+	std::vector<std::vector<double>> client_samples(num_clients);
+	std::vector<std::thread>         clients;
+
+	const auto start    = std::chrono::steady_clock::now();
+	const auto deadline = start + duration;
+	for (int c = 0; c < num_clients; ++c)
+	{
+		clients.emplace_back([this, deadline, &samples = client_samples[c]] {
+			auto buffers = allocateBuffers();
+			while (std::chrono::steady_clock::now() < deadline)
+			{
+				samples.push_back(timeInference(buffers));
+			}
+		});
+	}
+	for (auto &client : clients)
+	{
+		client.join();
+	}
+	const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<double> samples;
+	for (auto &client : client_samples)
+	{
+		samples.insert(samples.end(), client.begin(), client.end());
+	}
+
+	LoadPoint point;
+	point.concurrency  = num_clients;
+	point.achieved_rps = static_cast<double>(samples.size()) / elapsed;
+	point.latency      = LatencyStats::compute(std::move(samples));
+	point.latency.print();
+	std::cout << "Throughput: " << point.achieved_rps << " req/s" << std::endl;
+	return point;
+}
+
+std::vector<LoadPoint> Benchmark::runClosedLoopSweep(const std::vector<int> &client_counts, std::chrono::milliseconds duration) const
+{
+	std::vector<LoadPoint> points;
+	for (int clients : client_counts)
+	{
+		points.push_back(runClosedLoop(clients, duration, points.empty() ? 10 : 0));
+	}
+	printLoadCurve(points);
+	return points;
+}
+
+LoadPoint Benchmark::runOpenLoop(double target_rps, std::chrono::milliseconds duration,
+                                 ArrivalPattern arrivals, int num_workers, int num_warmup) const
+{
+	using Clock = std::chrono::steady_clock;
+
+	// The rate feeds exponential_distribution and the constant gap, both of
+	// which need it finite and positive.
+	if (!std::isfinite(target_rps) || target_rps <= 0 || num_workers <= 0)
+	{
+		std::cerr << "Open loop needs a positive, finite rate and at least one worker (got " << target_rps
+		          << " req/s, " << num_workers << " workers)" << std::endl;
+		return {};
+	}
+
+	prepare(num_warmup);
+	std::cout << "Open loop at " << target_rps << " req/s ("
+	          << (arrivals == ArrivalPattern::kPoisson ? "poisson" : "constant") << ", "
+	          << num_workers << " workers) for " << duration.count() << " ms..." << std::endl;
+
+	std::mutex                    mutex;
+	std::condition_variable       cv;
+	std::deque<Clock::time_point> arrivals_queue;
+	bool                          done = false;
+
+	std::vector<std::vector<double>> worker_samples(num_workers);
+	std::vector<std::thread>         workers;
+	for (int w = 0; w < num_workers; ++w)
+	{
+		workers.emplace_back([&, &samples = worker_samples[w]] {
+			auto buffers = allocateBuffers();
+			while (true)
+			{
+				Clock::time_point arrival;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cv.wait(lock, [&] { return done || !arrivals_queue.empty(); });
+					if (arrivals_queue.empty())
+					{
+						return;
+					}
+					arrival = arrivals_queue.front();
+					arrivals_queue.pop_front();
+				}
+
+				engine_->infer(buffers.inputs, buffers.outputs);
+				samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - arrival).count());
+			}
+		});
+	}
+
+	// Arrival times are scheduled up front from the target rate, so a slow
+	// server shows up as queueing delay rather than as a lower offered load.
+	std::mt19937_64                 rng(std::random_device{}());
+	std::exponential_distribution<> poisson(target_rps);
+	const auto                      start    = Clock::now();
+	const auto                      deadline = start + duration;
+	auto                            next     = start;
+	size_t                          issued   = 0;
+	while (next < deadline)
+	{
+		std::this_thread::sleep_until(next);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			arrivals_queue.push_back(next);
+		}
+		cv.notify_one();
+		++issued;
+
+		double gap = arrivals == ArrivalPattern::kPoisson ? poisson(rng) : 1.0 / target_rps;
+		next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		done = true;
+	}
+	cv.notify_all();
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+	const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
 
-	auto input_infos = engine_->getInputInfo();
+	std::vector<double> samples;
+	for (auto &worker : worker_samples)
+	{
+		samples.insert(samples.end(), worker.begin(), worker.end());
+	}
 
-	std::vector<std::vector<float>> input_buffers;
-	std::vector<const void *> inputs;
+	LoadPoint point;
+	point.concurrency  = num_workers;
+	point.offered_rps  = static_cast<double>(issued) / std::chrono::duration<double>(duration).count();
+	point.achieved_rps = static_cast<double>(samples.size()) / elapsed;
+	point.latency      = LatencyStats::compute(std::move(samples));
+	point.latency.print();
+	std::cout << "Offered: " << point.offered_rps << " req/s | Achieved: " << point.achieved_rps << " req/s" << std::endl;
+	return point;
+}
 
+std::vector<LoadPoint> Benchmark::runOpenLoopSweep(const std::vector<double> &target_rates, std::chrono::milliseconds duration,
+                                                   ArrivalPattern arrivals, int num_workers) const
+{
+	std::vector<LoadPoint> points;
+	for (double rate : target_rates)
+	{
+		LoadPoint point = runOpenLoop(rate, duration, arrivals, num_workers, points.empty() ? 10 : 0);
+		if (point.concurrency > 0)        // 0 when the rate was rejected
+		{
+			points.push_back(std::move(point));
+		}
+	}
+	printLoadCurve(points);
+	return points;
+}
+
+Benchmark::IoBuffers Benchmark::allocateBuffers() const
+{
+	IoBuffers buffers;
+	auto      input_infos  = engine_->getInputInfo();
+	auto      output_infos = engine_->getOutputInfo();
+
+	IMemoryAllocator *allocator = engine_->getHostAllocator();
 	for (const auto &desc : input_infos)
 	{
-		input_buffers.emplace_back(desc.getElementsCount(), 1.0f);
-		inputs.push_back(input_buffers.back().data());
+		TensorDesc host_desc = desc;
+		host_desc.mem_type   = MemoryType::kCPU;
+		auto tensor          = std::make_unique<Tensor>(host_desc, allocator);
+
+		std::fill_n(static_cast<float *>(tensor->data()), tensor->size() / sizeof(float), 1.0f);
+		if (isReducedFloat(desc.data_type))
+		{
+			std::vector<float> ones(desc.getElementsCount(), 1.0f);
+			convertDataType(ones.data(), DataType::kFLOAT32, tensor->data(), desc.data_type, ones.size());
+		}
+		buffers.inputs.push_back(tensor->data());
+		buffers.input_buffers.push_back(std::move(tensor));
 	}
 
 	// 创建输出缓冲区
-	std::vector<void *> outputs;
-	std::vector<std::vector<float>> output_buffers;
-	for (const auto &desc : engine_->getOutputInfo())
+	for (const auto &desc : output_infos)
 	{
-		output_buffers.emplace_back(desc.getElementsCount());
-		outputs.push_back(output_buffers.back().data());
+		TensorDesc host_desc = desc;
+		host_desc.mem_type   = MemoryType::kCPU;
+		auto tensor          = std::make_unique<Tensor>(host_desc, allocator);
+
+		std::memset(tensor->data(), 0, tensor->size());
+		buffers.outputs.push_back(tensor->data());
+		buffers.output_buffers.push_back(std::move(tensor));
 	}
 
-	std::cout << "Warmup with " << inputs.size() << " inputs and " << outputs.size() << " outputs..." << std::endl;
+	return buffers;
+}
+
+Benchmark::IoBuffers Benchmark::prepare(int num_warmup) const
+{
+	std::cout << std::endl
+	          << "[[" << engine_->getName() << "]]:" << std::endl;
+	engine_->printTensorInfo();
+
+	auto buffers = allocateBuffers();
+
+	std::cout << "Warmup with " << buffers.inputs.size() << " inputs and " << buffers.outputs.size() << " outputs..." << std::endl;
 	for (int i = 0; i < num_warmup; ++i)
 	{
-		engine_->infer(inputs, outputs);
+		engine_->infer(buffers.inputs, buffers.outputs);
 	}
 
-	std::cout << "Benchmarking..." << std::endl;
-	auto start = std::chrono::high_resolution_clock::now();
+	return buffers;
+}
 
-	for (int i = 0; i < num_infer; ++i)
+double Benchmark::timeInference(IoBuffers &buffers) const
+{
+	auto start = std::chrono::steady_clock::now();
+	engine_->infer(buffers.inputs, buffers.outputs);
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void Benchmark::report(const IoBuffers &buffers, const LatencyStats &stats) const
+{
+	// Widen half/bfloat16 outputs so the check prints real values.
+	auto                            output_infos = engine_->getOutputInfo();
+	std::vector<std::vector<float>> output_values;
+	output_values.reserve(buffers.output_buffers.size());
+	for (size_t i = 0; i < buffers.output_buffers.size(); ++i)
 	{
-		engine_->infer(inputs, outputs);
+		const auto  &desc   = output_infos[i];
+		const auto  *values = static_cast<const float *>(buffers.output_buffers[i]->data());
+		const size_t count  = std::min(desc.getElementsCount(), buffers.output_buffers[i]->size() / sizeof(float));
+		if (isReducedFloat(desc.data_type))
+		{
+			output_values.emplace_back(desc.getElementsCount());
+			convertDataType(values, desc.data_type, output_values.back().data(), DataType::kFLOAT32,
+			                desc.getElementsCount());
+		}
+		else
+		{
+			output_values.emplace_back(values, values + count);
+		}
 	}
+	printSimpleOutputCheck(output_values);
 
-	auto end = std::chrono::high_resolution_clock::now();
-	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-
-	printSimpleOutputCheck(output_buffers);
+	stats.print();
+	stats.printHistogram();
+	std::cout << "Average inference time: " << stats.mean_ms << " ms" << std::endl;
+	std::cout << "FPS: " << stats.getThroughput() << std::endl
+	          << std::endl;
 
-	float avg_time = duration.count() / 1000.0f / num_infer;
-	std::cout << "Average inference time: " << avg_time << " ms" << std::endl;
-	std::cout << "FPS: " << 1000.0f / avg_time << std::endl << std::endl;
+	if (auto allocator_stats = getAllocatorStats(*engine_))
+	{
+		allocator_stats->print();
+	}
 }
-}        // namespace gomang
\ No newline at end of file
+}        // namespace gomang
@@ -1,13 +1,56 @@
 #pragma once
 
+#include <functional>
+#include <optional>
 #include <utility>
 
 #include "core/engine.h"
+#include "core/tracking_allocator.h"
+#include "latency_stats.h"
 
 #include <chrono>
 #include <iostream>
 namespace gomang
 {
+enum class ArrivalPattern
+{
+	kConstant,
+	kPoisson
+};
+
+// One point of a throughput/latency curve. offered_rps is 0 for closed-loop runs.
+struct LoadPoint
+{
+	int          concurrency{0};
+	double       offered_rps{0};
+	double       achieved_rps{0};
+	LatencyStats latency;
+};
+
+void printLoadCurve(const std::vector<LoadPoint> &points);
+
+// Startup cost of one engine: its construction phases (as marked by the
+// backend), then first_inference and steady_state (mean latency), each with
+// process memory right after it. Peak RSS is a process-wide high-water mark,
+// so compare backends from separate processes.
+struct ColdStartProfile
+{
+	std::string            engine_name;
+	ProcessMemory          baseline;        // before construction started
+	double                 construct_ms{0};
+	std::vector<LoadPhase> phases;
+	LatencyStats           steady_state;
+
+	// Set when the engine's host allocator is a TrackingAllocator.
+	std::optional<AllocatorStats> allocator_stats;
+
+	void print() const;
+};
+
+// Combined stats of the engine's host and device allocators that are
+// TrackingAllocators; nullopt if neither is.
+std::optional<AllocatorStats> getAllocatorStats(const IEngine &engine);
+
 class Benchmark
 {
   public:
@@ -15,9 +58,51 @@ class Benchmark
 	    engine_(std::move(engine))
 	{}
 
-	void run(int num_warmup = 10, int num_infer = 100) const;
+	LatencyStats run(int num_warmup = 10, int num_infer = 100) const;
+
+	// Same timing loop as run() without any console output.
+	LatencyStats measure(int num_warmup = 10, int num_infer = 100) const;
+
+	// Keeps iterating until the 95% confidence interval of the mean latency is
+	// narrower than target_ci_ratio * mean, or max_infer runs are reached.
+	LatencyStats runAdaptive(int num_warmup = 10, double target_ci_ratio = 0.02,
+	                         int min_infer = 30, int max_infer = 10000) const;
+
+	// Closed loop: num_clients threads each call infer() back to back. The
+	// engine must accept concurrent calls (e.g. an EnginePool).
+	LoadPoint              runClosedLoop(int num_clients, std::chrono::milliseconds duration, int num_warmup = 10) const;
+	std::vector<LoadPoint> runClosedLoopSweep(const std::vector<int> &client_counts, std::chrono::milliseconds duration) const;
+
+	// Open loop: requests arrive at target_rps regardless of completions and are
+	// served by num_workers threads; latency includes time spent queued. A rate
+	// that is not positive and finite, or num_workers < 1, gives an empty point
+	// (the sweep skips it).
+	LoadPoint              runOpenLoop(double target_rps, std::chrono::milliseconds duration,
+	                                   ArrivalPattern arrivals = ArrivalPattern::kPoisson, int num_workers = 1,
+	                                   int num_warmup = 10) const;
+	std::vector<LoadPoint> runOpenLoopSweep(const std::vector<double> &target_rates, std::chrono::milliseconds duration,
+	                                        ArrivalPattern arrivals = ArrivalPattern::kPoisson, int num_workers = 1) const;
+
+	// Builds the engine through create so its load is measured too.
+	static ColdStartProfile profileColdStart(const std::function<std::shared_ptr<IEngine>()> &create,
+	                                         int num_infer = 20);
 
   private:
+	// Allocated from the engine's host allocator, so a TrackingAllocator sees
+	// the benchmark's I/O as well.
+	struct IoBuffers
+	{
+		std::vector<std::unique_ptr<Tensor>> input_buffers;
+		std::vector<std::unique_ptr<Tensor>> output_buffers;
+		std::vector<const void *>            inputs;
+		std::vector<void *>                  outputs;
+	};
+
 	std::shared_ptr<IEngine> engine_;
+
+	IoBuffers allocateBuffers() const;
+	IoBuffers prepare(int num_warmup) const;
+	double    timeInference(IoBuffers &buffers) const;
+	void      report(const IoBuffers &buffers, const LatencyStats &stats) const;
 };
-}        // namespace gomang
\ No newline at end of file
+}        // namespace gomang
@@ -0,0 +1,254 @@
+#include "batching_engine.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace gomang
+{
+namespace
+{
+size_t getSampleBytes(const TensorDesc &desc)
+{
+	return desc.getElementsCount() / desc.shape[0] * getDataTypeSize(desc.data_type);
+}
+}        // namespace
+
+double BatchingStats::getAverageBatchSize() const
+{
+	return batches ? static_cast<double>(requests) / static_cast<double>(batches) : 0.0;
+}
+
+double BatchingStats::getOccupancy() const
+{
+	if (batch_size_histogram.size() < 2)
+	{
+		return 0.0;
+	}
+	return getAverageBatchSize() / static_cast<double>(batch_size_histogram.size() - 1);
+}
+
+void BatchingStats::print() const
+{
+	std::cout << "Batching: " << requests << " requests in " << batches << " batches"
+	          << " | avg batch: " << getAverageBatchSize()
+	          << " | occupancy: " << getOccupancy() * 100.0 << "%"
+	          << " | full: " << full_batches << " | deadline: " << deadline_batches << std::endl;
+}
+
+BatchingEngine::BatchingEngine(std::shared_ptr<IEngine> engine, BatchingOptions options) :
+    IEngine("", 0, "batching(" + engine->getName() + ")"),
+    engine_(std::move(engine)),
+    options_(options)
+{
+	auto inputs  = engine_->getInputInfo();
+	auto outputs = engine_->getOutputInfo();
+	if (inputs.empty() || outputs.empty() || inputs[0].shape.empty())
+	{
+		throw std::runtime_error("BatchingEngine: wrapped engine has no batched I/O");
+	}
+
+	engine_batch_size_ = static_cast<size_t>(inputs[0].shape[0]);
+	if (options_.max_batch_size == 0 || options_.max_batch_size > engine_batch_size_)
+	{
+		options_.max_batch_size = engine_batch_size_;
+	}
+
+	for (const auto &desc : inputs)
+	{
+		if (desc.shape.empty() || static_cast<size_t>(desc.shape[0]) != engine_batch_size_)
+		{
+			throw std::runtime_error("BatchingEngine: inputs disagree on batch size");
+		}
+		input_sample_bytes_.push_back(getSampleBytes(desc));
+		batch_inputs_.push_back(std::make_unique<Tensor>(desc, engine_->getHostAllocator()));
+
+		input_info_.push_back(desc);
+		input_info_.back().shape[0] = 1;
+	}
+
+	for (const auto &desc : outputs)
+	{
+		if (desc.shape.empty() || static_cast<size_t>(desc.shape[0]) != engine_batch_size_)
+		{
+			throw std::runtime_error("BatchingEngine: outputs disagree on batch size");
+		}
+		output_sample_bytes_.push_back(getSampleBytes(desc));
+		batch_outputs_.push_back(std::make_unique<Tensor>(desc, engine_->getHostAllocator()));
+
+		output_info_.push_back(desc);
+		output_info_.back().shape[0] = 1;
+	}
+
+	stats_.batch_size_histogram.assign(options_.max_batch_size + 1, 0);
+
+	scheduler_ = std::thread(&BatchingEngine::schedulerLoop, this);
+}
+
+BatchingEngine::~BatchingEngine()
+{
+	stopAsync();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	scheduler_.join();
+}
+
+bool BatchingEngine::infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs)
+{
+	return inferAsync(inputs, outputs).get();
+}
+
+void BatchingEngine::inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs, InferCallback callback)
+{
+	if (inputs.size() != input_info_.size() || outputs.size() != output_info_.size())
+	{
+		if (callback)
+		{
+			callback(false);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		queue_.push_back({std::move(inputs), std::move(outputs), std::move(callback), std::chrono::steady_clock::now()});
+	}
+	cv_.notify_all();
+}
+
+std::vector<TensorDesc> BatchingEngine::getInputInfo() const
+{
+	return input_info_;
+}
+
+std::vector<TensorDesc> BatchingEngine::getOutputInfo() const
+{
+	return output_info_;
+}
+
+BatchingStats BatchingEngine::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
+
+void BatchingEngine::resetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	stats_ = BatchingStats{};
+	stats_.batch_size_histogram.assign(options_.max_batch_size + 1, 0);
+}
+
+void BatchingEngine::schedulerLoop()
+{
+	std::vector<Request> batch;
+	batch.reserve(options_.max_batch_size);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+		if (queue_.empty())
+		{
+			return;
+		}
+
+		// Hold the batch open until it is full or the oldest request's deadline
+		// passes; on shutdown, flush whatever is queued.
+		const auto deadline = queue_.front().enqueue_time + options_.max_wait;
+		cv_.wait_until(lock, deadline, [this] { return stop_ || queue_.size() >= options_.max_batch_size; });
+
+		const size_t count = std::min(queue_.size(), options_.max_batch_size);
+		for (size_t i = 0; i < count; ++i)
+		{
+			batch.push_back(std::move(queue_.front()));
+			queue_.pop_front();
+		}
+
+		stats_.requests += count;
+		stats_.batches++;
+		stats_.batch_size_histogram[count]++;
+		if (count == options_.max_batch_size)
+		{
+			stats_.full_batches++;
+		}
+		else
+		{
+			stats_.deadline_batches++;
+		}
+
+		lock.unlock();
+		runBatch(batch);
+		batch.clear();
+		lock.lock();
+	}
+}
+
+void BatchingEngine::runBatch(std::vector<Request> &batch)
+{
+	std::vector<const void *> inputs;
+	for (size_t i = 0; i < batch_inputs_.size(); ++i)
+	{
+		auto *dst = static_cast<uint8_t *>(batch_inputs_[i]->data());
+		for (size_t b = 0; b < batch.size(); ++b)
+		{
+			memcpy(dst + b * input_sample_bytes_[i], batch[b].inputs[i], input_sample_bytes_[i]);
+		}
+		inputs.push_back(dst);
+	}
+
+	std::vector<void *> outputs;
+	for (auto &tensor : batch_outputs_)
+	{
+		outputs.push_back(tensor->data());
+	}
+
+	bool ok = false;
+	try
+	{
+		ok = engine_->infer(inputs, outputs);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "[" << name_ << "] batched inference failed: " << e.what() << std::endl;
+	}
+	catch (...)
+	{
+		std::cerr << "[" << name_ << "] batched inference failed with an unknown exception" << std::endl;
+	}
+
+	for (size_t b = 0; b < batch.size(); ++b)
+	{
+		if (ok)
+		{
+			for (size_t i = 0; i < batch_outputs_.size(); ++i)
+			{
+				const auto *src = static_cast<const uint8_t *>(batch_outputs_[i]->data());
+				memcpy(batch[b].outputs[i], src + b * output_sample_bytes_[i], output_sample_bytes_[i]);
+			}
+		}
+
+		if (!batch[b].callback)
+		{
+			continue;
+		}
+		// A throwing callback must neither skip the rest of the batch nor take
+		// the scheduler thread down.
+		try
+		{
+			batch[b].callback(ok);
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "[" << name_ << "] request callback failed: " << e.what() << std::endl;
+		}
+		catch (...)
+		{
+			std::cerr << "[" << name_ << "] request callback failed with an unknown exception" << std::endl;
+		}
+	}
+}
+}        // namespace gomang
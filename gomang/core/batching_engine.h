@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#include "engine.h"
+
+namespace gomang
+{
+struct BatchingOptions
+{
+	size_t                    max_batch_size{0};        // 0: batch dimension of the wrapped engine
+	std::chrono::microseconds max_wait{2000};           // deadline measured from the oldest queued request
+};
+
+struct BatchingStats
+{
+	uint64_t              requests{0};
+	uint64_t              batches{0};
+	uint64_t              full_batches{0};
+	uint64_t              deadline_batches{0};
+	std::vector<uint64_t> batch_size_histogram;        // index = number of requests in the batch
+
+	[[nodiscard]] double getAverageBatchSize() const;
+	[[nodiscard]] double getOccupancy() const;        // average batch size / max batch size
+	void                 print() const;
+};
+
+// Collects concurrent single-sample requests and runs them as one batched
+// call on the wrapped engine. The wrapped engine's inputs and outputs must be
+// batch-major with the batch in shape[0]; unused batch slots are left as is
+// and their outputs discarded.
+class BatchingEngine : public IEngine
+{
+  public:
+	BatchingEngine(std::shared_ptr<IEngine> engine, BatchingOptions options = {});
+
+	~BatchingEngine() override;
+
+	using IEngine::infer;
+	using IEngine::inferAsync;
+
+	bool infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs) override;
+
+	void inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs, InferCallback callback) override;
+
+	// Shapes of a single sample, i.e. the wrapped engine's with shape[0] == 1.
+	[[nodiscard]] std::vector<TensorDesc> getInputInfo() const override;
+	[[nodiscard]] std::vector<TensorDesc> getOutputInfo() const override;
+
+	[[nodiscard]] BatchingStats getStats() const;
+	void                        resetStats();
+
+  private:
+	struct Request
+	{
+		std::vector<const void *>             inputs;
+		std::vector<void *>                   outputs;
+		InferCallback                         callback;
+		std::chrono::steady_clock::time_point enqueue_time;
+	};
+
+	std::shared_ptr<IEngine> engine_;
+	BatchingOptions          options_;
+	size_t                   engine_batch_size_{1};
+
+	std::vector<TensorDesc> input_info_;
+	std::vector<TensorDesc> output_info_;
+	std::vector<size_t>     input_sample_bytes_;
+	std::vector<size_t>     output_sample_bytes_;
+
+	std::vector<std::unique_ptr<Tensor>> batch_inputs_;
+	std::vector<std::unique_ptr<Tensor>> batch_outputs_;
+
+	mutable std::mutex      mutex_;
+	std::condition_variable cv_;
+	std::deque<Request>     queue_;
+	bool                    stop_{false};
+	BatchingStats           stats_;
+	std::thread             scheduler_;
+
+	void schedulerLoop();
+	void runBatch(std::vector<Request> &batch);
+};
+}        // namespace gomang
@@ -1,24 +1,247 @@
 #include "engine.h"
 
+#include "layout.h"
+#include "precision.h"
+
 namespace gomang
 {
 
+IEngine::~IEngine()
+{
+	stopAsync();
+}
+
+namespace
+{
+// The engine-side descriptor a caller tensor is staged into.
+TensorDesc toNative(const TensorDesc &desc, const TensorDesc &native)
+{
+	TensorDesc result = withLayout(desc, native.layout);
+	result.data_type  = native.data_type;
+	return result;
+}
+
+// Caller tensors reach the pointer overload as plain host buffers, so they
+// must hold the native shape (in any layout) and be large enough for it.
+bool fitsNative(const ITensor &tensor, const TensorDesc &native)
+{
+	const auto &desc = tensor.desc();
+	return desc.mem_type != MemoryType::kGPU && withLayout(desc, native.layout).shape == native.shape &&
+	       tensor.size() >= desc.getByteSize();
+}
+
+bool needsStaging(const TensorDesc &desc, const TensorDesc &native)
+{
+	return desc.layout != native.layout || desc.data_type != native.data_type;
+}
+
+// Converts data type first and layout second, going through a temporary only
+// when both differ.
+bool convertTensor(const ITensor &src, ITensor &dst, unsigned int num_threads)
+{
+	const auto &src_desc = src.desc();
+	const auto &dst_desc = dst.desc();
+
+	if (src_desc.data_type == dst_desc.data_type)
+	{
+		return convertLayout(src.data(), src_desc, dst.data(), dst_desc, num_threads);
+	}
+	if (src_desc.layout == dst_desc.layout)
+	{
+		return convertDataType(src.data(), src_desc.data_type, dst.data(), dst_desc.data_type,
+		                       src_desc.getElementsCount(), num_threads);
+	}
+
+	TensorDesc tmp_desc = src_desc;
+	tmp_desc.data_type  = dst_desc.data_type;
+	Tensor tmp(tmp_desc, nullptr);
+	return convertDataType(src.data(), src_desc.data_type, tmp.data(), tmp_desc.data_type,
+	                       src_desc.getElementsCount(), num_threads) &&
+	       convertLayout(tmp.data(), tmp_desc, dst.data(), dst_desc, num_threads);
+}
+}        // namespace
+
+bool IEngine::infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs)
+{
+	const auto input_info  = getInputInfo();
+	const auto output_info = getOutputInfo();
+	if (inputs.size() != input_info.size() || outputs.size() != output_info.size())
+	{
+		std::cerr << "[" << name_ << "] expected " << input_info.size() << " inputs and " << output_info.size()
+		          << " outputs, got " << inputs.size() << " and " << outputs.size() << std::endl;
+		return false;
+	}
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		if (!fitsNative(*inputs[i], input_info[i]))
+		{
+			std::cerr << "[" << name_ << "] input " << i << " does not match the model input" << std::endl;
+			return false;
+		}
+	}
+	for (size_t i = 0; i < outputs.size(); ++i)
+	{
+		if (!fitsNative(*outputs[i], output_info[i]))
+		{
+			std::cerr << "[" << name_ << "] output " << i << " does not match the model output" << std::endl;
+			return false;
+		}
+	}
+
+	// Tensors whose layout or data type differs from the engine's native one are
+	// staged and converted with the core layout and precision kernels.
+	std::vector<std::unique_ptr<Tensor>> staging;
+
+	std::vector<const void *> input_ptrs;
+	input_ptrs.reserve(inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		if (needsStaging(inputs[i]->desc(), input_info[i]))
+		{
+			staging.push_back(std::make_unique<Tensor>(toNative(inputs[i]->desc(), input_info[i]), host_allocator_.get()));
+			if (!convertTensor(*inputs[i], *staging.back(), num_threads_))
+			{
+				return false;
+			}
+			input_ptrs.push_back(staging.back()->data());
+		}
+		else
+		{
+			input_ptrs.push_back(inputs[i]->data());
+		}
+	}
+
+	std::vector<void *>                         output_ptrs;
+	std::vector<std::pair<Tensor *, ITensor *>> converted_outputs;
+	output_ptrs.reserve(outputs.size());
+	for (size_t i = 0; i < outputs.size(); ++i)
+	{
+		if (needsStaging(outputs[i]->desc(), output_info[i]))
+		{
+			staging.push_back(std::make_unique<Tensor>(toNative(outputs[i]->desc(), output_info[i]), host_allocator_.get()));
+			converted_outputs.emplace_back(staging.back().get(), outputs[i]);
+			output_ptrs.push_back(staging.back()->data());
+		}
+		else
+		{
+			output_ptrs.push_back(outputs[i]->data());
+		}
+	}
+
+	if (!infer(input_ptrs, output_ptrs))
+	{
+		return false;
+	}
+
+	for (auto &[native, output] : converted_outputs)
+	{
+		if (!convertTensor(*native, *output, num_threads_))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void IEngine::inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs, InferCallback callback)
+{
+	std::call_once(infer_queue_once_, [this] { infer_queue_ = std::make_unique<InferQueue>(); });
+
+	infer_queue_->submit([this, inputs = std::move(inputs), outputs = std::move(outputs), callback = std::move(callback)] {
+		bool ok = false;
+		try
+		{
+			ok = infer(inputs, outputs);
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "[" << name_ << "] async inference failed: " << e.what() << std::endl;
+		}
+		catch (...)
+		{
+			std::cerr << "[" << name_ << "] async inference failed with an unknown exception" << std::endl;
+		}
+
+		if (callback)
+		{
+			callback(ok);
+		}
+	});
+}
+
+std::future<bool> IEngine::inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs)
+{
+	auto promise = std::make_shared<std::promise<bool>>();
+	auto future  = promise->get_future();
+
+	inferAsync(std::move(inputs), std::move(outputs), [promise](bool ok) { promise->set_value(ok); });
+
+	return future;
+}
+
+void IEngine::stopAsync()
+{
+	infer_queue_.reset();
+}
+
+std::shared_ptr<IEngine> IEngine::clone() const
+{
+	return nullptr;
+}
+
 const std::string &IEngine::getName() const
 {
 	return name_;
 }
 
+Precision IEngine::getPrecision() const
+{
+	return precision_;
+}
+
+IMemoryAllocator *IEngine::getHostAllocator() const
+{
+	return host_allocator_.get();
+}
+
+IMemoryAllocator *IEngine::getDeviceAllocator() const
+{
+	return device_allocator_.get();
+}
+
+const std::vector<LoadPhase> &IEngine::getLoadPhases() const
+{
+	return load_phases_;
+}
+
 IEngine::IEngine(std::string model_path, unsigned int num_threads, std::string name) :
     model_path_(std::move(model_path)),
     num_threads_(num_threads),
-    name_(std::move(name))
+    name_(std::move(name)),
+    load_mark_(std::chrono::steady_clock::now())
 {
 }
+
+void IEngine::markLoadPhase(std::string phase_name)
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	LoadPhase phase;
+	phase.name        = std::move(phase_name);
+	phase.duration_ms = std::chrono::duration<double, std::milli>(now - load_mark_).count();
+	phase.memory      = readProcessMemory();
+	load_phases_.push_back(std::move(phase));
+
+	// Sampling /proc is not charged to the next phase.
+	load_mark_ = std::chrono::steady_clock::now();
+}
 void IEngine::printTensorInfo() const
 {
 	const auto input_info  = getInputInfo();
 	const auto output_info = getOutputInfo();
 
+	std::cout << "Precision: " << getPrecisionName(precision_) << "\n";
 	std::cout << "================== Input Info ==================\n";
 	for (const auto &desc : input_info)
 	{
@@ -1,17 +1,35 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <utility>
 
+#include "infer_queue.h"
+#include "precision.h"
+#include "process_memory.h"
 #include "tensor.h"
 
 namespace gomang
 {
+// One step of engine construction: time since the previous step (or since
+// construction began) and process memory right after it.
+struct LoadPhase
+{
+	std::string   name;
+	double        duration_ms{0};
+	ProcessMemory memory;
+};
+
 class IEngine
 {
   public:
-	virtual ~IEngine() = default;
+	using InferCallback = std::function<void(bool)>;
+
+	virtual ~IEngine();
 
 	IEngine(const IEngine &)            = delete;
 	IEngine(IEngine &&)                 = delete;
@@ -24,11 +42,48 @@ class IEngine
 	    const std::vector<const void *> &inputs,
 	    const std::vector<void *>       &outputs) = 0;
 
+	// Backends override this to bind caller memory directly when layout and
+	// alignment allow; the default forwards the raw data pointers.
+	virtual bool infer(
+	    const std::vector<const ITensor *> &inputs,
+	    const std::vector<ITensor *>       &outputs);
+
+	// Queues the request on the engine's submission worker and returns at once.
+	// The buffers must stay valid until the callback has run. Backends with
+	// native async execution override this; the default runs infer() in order
+	// on a per-engine worker thread.
+	virtual void inferAsync(
+	    std::vector<const void *> inputs,
+	    std::vector<void *>       outputs,
+	    InferCallback             callback);
+
+	std::future<bool> inferAsync(
+	    std::vector<const void *> inputs,
+	    std::vector<void *>       outputs);
+
+	// New execution instance that shares this engine's loaded weights but has
+	// its own activation memory, so one instance per core does not multiply
+	// RSS by the weights. nullptr when the backend cannot share them.
+	[[nodiscard]] virtual std::shared_ptr<IEngine> clone() const;
+
 	[[nodiscard]] virtual std::vector<TensorDesc> getInputInfo() const  = 0;
 	[[nodiscard]] virtual std::vector<TensorDesc> getOutputInfo() const = 0;
 
 	[[nodiscard]] const std::string &getName() const;
 
+	[[nodiscard]] Precision getPrecision() const;
+
+	// Allocator for buffers the engine and its wrappers allocate on the host;
+	// nullptr means std::aligned_alloc.
+	[[nodiscard]] IMemoryAllocator *getHostAllocator() const;
+
+	// Allocator for device/pinned buffers the backend owns; nullptr if the
+	// backend uses its built-in one or has none.
+	[[nodiscard]] IMemoryAllocator *getDeviceAllocator() const;
+
+	// Construction phases in order, as marked by the backend.
+	[[nodiscard]] const std::vector<LoadPhase> &getLoadPhases() const;
+
 	void printTensorInfo() const;
 
   protected:
@@ -37,6 +92,29 @@ class IEngine
 
 	std::string name_{};
 
+	// Set by backends that run in reduced precision; I/O tensors keep the data
+	// types reported by getInputInfo()/getOutputInfo().
+	Precision precision_{Precision::kFP32};
+
+	// Set from EngineOptions::host_allocator by backends that take options.
+	std::shared_ptr<IMemoryAllocator> host_allocator_;
+	std::shared_ptr<IMemoryAllocator> device_allocator_;
+
 	IEngine(std::string model_path, unsigned int num_threads, std::string name);
+
+	// Closes the current load phase, e.g. "deserialize" right after the model
+	// is parsed; backends call it from their constructors.
+	void markLoadPhase(std::string phase_name);
+
+	// Drains and joins the async worker. Derived destructors call this first so
+	// no queued request reaches a partially destroyed engine.
+	void stopAsync();
+
+  private:
+	std::unique_ptr<InferQueue> infer_queue_;
+	std::once_flag              infer_queue_once_;
+
+	std::vector<LoadPhase>                load_phases_;
+	std::chrono::steady_clock::time_point load_mark_;
 };
 }        // namespace gomang
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+
+#include "memory.h"
+#include "precision.h"
+
+namespace gomang
+{
+enum class Device
+{
+	kDefault,        // backend default: MNN tries CUDA, ncnn tries Vulkan, both fall back to CPU
+	kCPU,
+	kGPU
+};
+
+// MNN::BackendConfig::MemoryMode; kLow also turns on ncnn light mode.
+enum class MemoryMode
+{
+	kNormal,
+	kHigh,
+	kLow
+};
+
+// MNN::BackendConfig::PowerMode; for ncnn, the cores threads run on
+// (kNormal all, kHigh big cores only, kLow little cores only). ncnn's setting
+// is process-wide: kHigh/kLow apply to every ncnn engine in the process, and
+// kNormal leaves the current setting unchanged.
+enum class PowerMode
+{
+	kNormal,
+	kHigh,
+	kLow
+};
+
+// Construction-time tuning shared by all backends. Each field is applied where
+// the backend has an equivalent and ignored otherwise.
+struct EngineOptions
+{
+	unsigned int num_threads{1};
+	Device       device{Device::kDefault};
+	Precision    precision{Precision::kFP32};
+	MemoryMode   memory_mode{MemoryMode::kHigh};
+	PowerMode    power_mode{PowerMode::kNormal};
+
+	// ncnn convolution algorithm and layout toggles.
+	bool use_winograd{true};
+	bool use_sgemm{true};
+	bool use_packing{true};
+
+	// Release intermediate blobs as soon as they are consumed (ncnn extractor).
+	// ncnn already does this for single-output models.
+	bool light_mode{false};
+
+	// Host memory for the buffers the engine allocates itself (layout/precision
+	// staging, batch buffers, ncnn blobs and workspaces), e.g. a NumaAllocator
+	// bound to the engine's node. nullptr uses each backend's default.
+	std::shared_ptr<IMemoryAllocator> host_allocator;
+
+	// Device and pinned memory the engine allocates itself (TensorRT I/O
+	// bindings), e.g. a TrackingAllocator over a TrtAllocator. nullptr uses the
+	// backend's own allocator.
+	std::shared_ptr<IMemoryAllocator> device_allocator;
+};
+}        // namespace gomang
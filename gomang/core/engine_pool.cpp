@@ -0,0 +1,226 @@
+#include "engine_pool.h"
+
+#include <stdexcept>
+
+namespace gomang
+{
+EnginePool::Lease::Lease(EnginePool *pool, uint32_t index) :
+    pool_(pool), index_(index)
+{
+}
+
+EnginePool::Lease::Lease(Lease &&other) noexcept :
+    pool_(other.pool_), index_(other.index_)
+{
+	other.pool_ = nullptr;
+}
+
+EnginePool::Lease &EnginePool::Lease::operator=(Lease &&other) noexcept
+{
+	if (this != &other)
+	{
+		if (pool_)
+		{
+			pool_->releaseIndex(index_);
+		}
+		pool_       = other.pool_;
+		index_      = other.index_;
+		other.pool_ = nullptr;
+	}
+	return *this;
+}
+
+EnginePool::Lease::~Lease()
+{
+	if (pool_)
+	{
+		pool_->releaseIndex(index_);
+	}
+}
+
+IEngine *EnginePool::Lease::operator->() const
+{
+	return pool_->engines_[index_].get();
+}
+
+IEngine &EnginePool::Lease::operator*() const
+{
+	return *pool_->engines_[index_];
+}
+
+size_t EnginePool::Lease::getIndex() const
+{
+	return index_;
+}
+
+EnginePool::EnginePool(std::vector<std::shared_ptr<IEngine>> engines) :
+    IEngine("", 0, engines.empty() ? "pool" : "pool(" + engines[0]->getName() + ")"),
+    engines_(std::move(engines))
+{
+	initFreeList();
+}
+
+EnginePool::EnginePool(const EngineFactory &factory, size_t count) :
+    IEngine("", 0, "pool")
+{
+	engines_.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		engines_.push_back(factory());
+	}
+	if (!engines_.empty())
+	{
+		name_ = "pool(" + engines_[0]->getName() + ")";
+	}
+	initFreeList();
+}
+
+EnginePool::EnginePool(std::shared_ptr<IEngine> prototype, size_t count) :
+    IEngine("", 0, "pool(" + prototype->getName() + ")")
+{
+	engines_.reserve(count);
+	for (size_t i = 1; i < count; ++i)
+	{
+		auto engine = prototype->clone();
+		if (!engine)
+		{
+			throw std::runtime_error("EnginePool: " + prototype->getName() + " does not support clone()");
+		}
+		engines_.push_back(std::move(engine));
+	}
+	if (count > 0)
+	{
+		engines_.push_back(std::move(prototype));
+	}
+	initFreeList();
+}
+
+EnginePool::~EnginePool()
+{
+	stopAsync();
+
+	// Wait for requests still running on pooled engines.
+	for (size_t i = 0; i < engines_.size(); ++i)
+	{
+		available_.acquire();
+	}
+}
+
+bool EnginePool::infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs)
+{
+	auto lease = acquire();
+	return lease->infer(inputs, outputs);
+}
+
+bool EnginePool::infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs)
+{
+	auto lease = acquire();
+	return lease->infer(inputs, outputs);
+}
+
+void EnginePool::inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs, InferCallback callback)
+{
+	uint32_t index = acquireIndex();
+	engines_[index]->inferAsync(std::move(inputs), std::move(outputs),
+	                            [this, index, callback = std::move(callback)](bool ok) {
+		                            releaseIndex(index);
+		                            if (callback)
+		                            {
+			                            callback(ok);
+		                            }
+	                            });
+}
+
+std::vector<TensorDesc> EnginePool::getInputInfo() const
+{
+	return engines_[0]->getInputInfo();
+}
+
+std::vector<TensorDesc> EnginePool::getOutputInfo() const
+{
+	return engines_[0]->getOutputInfo();
+}
+
+EnginePool::Lease EnginePool::acquire()
+{
+	return {this, acquireIndex()};
+}
+
+std::optional<EnginePool::Lease> EnginePool::tryAcquire(std::chrono::microseconds timeout)
+{
+	if (!available_.try_acquire_for(timeout))
+	{
+		return std::nullopt;
+	}
+	available_count_.fetch_sub(1, std::memory_order_relaxed);
+	return Lease(this, pop());
+}
+
+size_t EnginePool::size() const
+{
+	return engines_.size();
+}
+
+size_t EnginePool::getAvailableCount() const
+{
+	return available_count_.load(std::memory_order_relaxed);
+}
+
+void EnginePool::push(uint32_t index)
+{
+	uint64_t head = head_.load(std::memory_order_relaxed);
+	uint64_t desired;
+	do
+	{
+		next_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+		desired = (((head >> 32) + 1) << 32) | index;
+	} while (!head_.compare_exchange_weak(head, desired, std::memory_order_release, std::memory_order_relaxed));
+}
+
+uint32_t EnginePool::pop()
+{
+	uint64_t head = head_.load(std::memory_order_acquire);
+	uint64_t desired;
+	do
+	{
+		auto index = static_cast<uint32_t>(head);
+		if (index == kEmpty)
+		{
+			return kEmpty;
+		}
+		desired = (head & 0xFFFFFFFF00000000ull) | next_[index].load(std::memory_order_relaxed);
+	} while (!head_.compare_exchange_weak(head, desired, std::memory_order_acquire, std::memory_order_acquire));
+
+	return static_cast<uint32_t>(head);
+}
+
+uint32_t EnginePool::acquireIndex()
+{
+	// A successful semaphore acquire reserves one entry on the stack, so the pop
+	// below cannot come back empty.
+	available_.acquire();
+	available_count_.fetch_sub(1, std::memory_order_relaxed);
+	return pop();
+}
+
+void EnginePool::releaseIndex(uint32_t index)
+{
+	push(index);
+	available_count_.fetch_add(1, std::memory_order_relaxed);
+	available_.release();
+}
+
+void EnginePool::initFreeList()
+{
+	if (engines_.empty())
+	{
+		throw std::runtime_error("EnginePool: no engines");
+	}
+
+	next_ = std::make_unique<std::atomic<uint32_t>[]>(engines_.size());
+	for (size_t i = engines_.size(); i-- > 0;)
+	{
+		releaseIndex(static_cast<uint32_t>(i));
+	}
+}
+}        // namespace gomang
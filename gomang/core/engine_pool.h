@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <semaphore>
+
+#include "engine.h"
+
+namespace gomang
+{
+// Owns N interchangeable engine instances and hands each concurrent request a
+// free one. Free instances live on a lock-free stack; a counting semaphore
+// tracks how many are available so acquire can block or time out.
+class EnginePool : public IEngine
+{
+  public:
+	using EngineFactory = std::function<std::shared_ptr<IEngine>()>;
+
+	// Exclusive use of one pooled engine; returns it to the pool when destroyed.
+	class Lease
+	{
+	  public:
+		Lease(Lease &&other) noexcept;
+		Lease &operator=(Lease &&other) noexcept;
+		~Lease();
+
+		Lease(const Lease &)            = delete;
+		Lease &operator=(const Lease &) = delete;
+
+		IEngine *operator->() const;
+		IEngine &operator*() const;
+
+		[[nodiscard]] size_t getIndex() const;
+
+	  private:
+		friend class EnginePool;
+
+		Lease(EnginePool *pool, uint32_t index);
+
+		EnginePool *pool_;
+		uint32_t    index_;
+	};
+
+	explicit EnginePool(std::vector<std::shared_ptr<IEngine>> engines);
+	EnginePool(const EngineFactory &factory, size_t count);
+
+	// prototype plus count - 1 clones sharing its weights; throws if the
+	// backend does not support clone().
+	EnginePool(std::shared_ptr<IEngine> prototype, size_t count);
+
+	~EnginePool() override;
+
+	using IEngine::infer;
+	using IEngine::inferAsync;
+
+	bool infer(const std::vector<const void *> &inputs, const std::vector<void *> &outputs) override;
+	bool infer(const std::vector<const ITensor *> &inputs, const std::vector<ITensor *> &outputs) override;
+
+	// Blocks for a free instance, then hands the request to that instance's
+	// own async path so several requests run concurrently.
+	void inferAsync(std::vector<const void *> inputs, std::vector<void *> outputs, InferCallback callback) override;
+
+	[[nodiscard]] std::vector<TensorDesc> getInputInfo() const override;
+	[[nodiscard]] std::vector<TensorDesc> getOutputInfo() const override;
+
+	Lease                              acquire();
+	[[nodiscard]] std::optional<Lease> tryAcquire(std::chrono::microseconds timeout = std::chrono::microseconds(0));
+
+	[[nodiscard]] size_t size() const;
+	[[nodiscard]] size_t getAvailableCount() const;
+
+  private:
+	static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+
+	std::vector<std::shared_ptr<IEngine>> engines_;
+
+	// Treiber stack of free indices. head_ packs {tag:32, index:32}; the tag is
+	// bumped on every push so a stale pop cannot succeed (ABA).
+	std::atomic<uint64_t>                    head_{kEmpty};
+	std::unique_ptr<std::atomic<uint32_t>[]> next_;
+	std::atomic<size_t>                      available_count_{0};
+	std::counting_semaphore<>                available_{0};
+
+	void     push(uint32_t index);
+	uint32_t pop();
+
+	uint32_t acquireIndex();
+	void     releaseIndex(uint32_t index);
+
+	void initFreeList();
+};
+}        // namespace gomang
@@ -0,0 +1,83 @@
+#include "infer_queue.h"
+
+#include <exception>
+#include <iostream>
+
+namespace gomang
+{
+InferQueue::InferQueue() :
+    worker_(&InferQueue::workerLoop, this)
+{
+}
+
+InferQueue::~InferQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	worker_.join();
+}
+
+void InferQueue::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.push_back(std::move(task));
+	}
+	cv_.notify_one();
+}
+
+void InferQueue::waitIdle()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	idle_cv_.wait(lock, [this] { return tasks_.empty() && !running_task_; });
+}
+
+size_t InferQueue::getPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return tasks_.size() + (running_task_ ? 1 : 0);
+}
+
+void InferQueue::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+		if (tasks_.empty())
+		{
+			// stop_ is set and everything queued before it has run.
+			return;
+		}
+
+		auto task = std::move(tasks_.front());
+		tasks_.pop_front();
+		running_task_ = true;
+
+		lock.unlock();
+		try
+		{
+			task();
+		}
+		catch (const std::exception &e)
+		{
+			// A throwing task (or its callback) must not take the worker down.
+			std::cerr << "InferQueue: task failed: " << e.what() << std::endl;
+		}
+		catch (...)
+		{
+			std::cerr << "InferQueue: task failed with an unknown exception" << std::endl;
+		}
+		lock.lock();
+
+		running_task_ = false;
+		if (tasks_.empty())
+		{
+			idle_cv_.notify_all();
+		}
+	}
+}
+}        // namespace gomang
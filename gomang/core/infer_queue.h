@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace gomang
+{
+// Single worker thread draining a FIFO of submitted tasks.
+class InferQueue
+{
+  public:
+	InferQueue();
+	~InferQueue();
+
+	InferQueue(const InferQueue &)            = delete;
+	InferQueue &operator=(const InferQueue &) = delete;
+
+	void submit(std::function<void()> task);
+
+	// Blocks until every task submitted so far has finished.
+	void waitIdle();
+
+	[[nodiscard]] size_t getPendingCount() const;
+
+  private:
+	mutable std::mutex                mutex_;
+	std::condition_variable           cv_;
+	std::condition_variable           idle_cv_;
+	std::deque<std::function<void()>> tasks_;
+	bool                              running_task_{false};
+	bool                              stop_{false};
+	std::thread                       worker_;
+
+	void workerLoop();
+};
+}        // namespace gomang
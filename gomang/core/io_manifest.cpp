@@ -0,0 +1,191 @@
+#include "io_manifest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <unistd.h>
+
+#include "mapped_file.h"
+
+namespace gomang
+{
+namespace
+{
+constexpr char kManifestMagic[] = "gomang-io";
+constexpr int  kManifestVersion = 1;
+constexpr char kUnnamed[]       = "-";
+
+void writeDesc(std::ostream &out, const char *kind, const TensorDesc &desc)
+{
+	out << kind << ' ' << (desc.name.empty() ? kUnnamed : desc.name) << ' ' << static_cast<int>(desc.data_type) << ' '
+	    << static_cast<int>(desc.layout) << ' ' << static_cast<int>(desc.mem_type) << ' '
+	    << desc.alignment << ' ' << desc.shape.size();
+	for (auto dim : desc.shape)
+	{
+		out << ' ' << dim;
+	}
+	out << '\n';
+}
+
+bool readDesc(const std::string &line, const char *kind, TensorDesc &desc)
+{
+	std::istringstream in(line);
+	std::string        tag;
+	int                data_type = 0;
+	int                layout    = 0;
+	int                mem_type  = 0;
+	size_t             rank      = 0;
+	if (!(in >> tag >> desc.name >> data_type >> layout >> mem_type >> desc.alignment >> rank) || tag != kind ||
+	    rank > 8)
+	{
+		return false;
+	}
+
+	if (desc.name == kUnnamed)
+	{
+		desc.name.clear();
+	}
+	desc.data_type = static_cast<DataType>(data_type);
+	desc.layout    = static_cast<MemoryLayout>(layout);
+	desc.mem_type  = static_cast<MemoryType>(mem_type);
+	desc.shape.resize(rank);
+	for (auto &dim : desc.shape)
+	{
+		if (!(in >> dim))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool sameInput(const TensorDesc &a, const TensorDesc &b)
+{
+	return a.shape == b.shape && a.data_type == b.data_type && a.layout == b.layout;
+}
+}        // namespace
+
+uint64_t hashModelBytes(const void *data, size_t size, uint64_t seed)
+{
+	// FNV-1a over 64-bit words rather than bytes; models run to hundreds of MB
+	// and this sits on the startup path.
+	constexpr uint64_t kPrime = 0x100000001b3ull;
+
+	const auto *bytes = static_cast<const uint8_t *>(data);
+	uint64_t    hash  = (seed ^ size) * kPrime;
+	size_t      i     = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * kPrime;
+	}
+	for (; i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * kPrime;
+	}
+	return hash;
+}
+
+bool hashModelFile(const std::string &path, uint64_t &hash, uint64_t seed)
+{
+	MappedFile file;
+	if (!file.open(path))
+	{
+		std::cerr << file.getError() << std::endl;
+		return false;
+	}
+	hash = hashModelBytes(file.data(), file.size(), seed);
+	return true;
+}
+
+std::string getIoManifestPath(const std::string &model_path)
+{
+	return model_path + ".io";
+}
+
+bool loadIoManifest(const std::string &manifest_path, uint64_t model_hash,
+                    const std::vector<TensorDesc> &inputs, std::vector<TensorDesc> &outputs)
+{
+	std::ifstream in(manifest_path);
+	if (!in)
+	{
+		return false;
+	}
+
+	std::string magic;
+	int         version      = 0;
+	uint64_t    hash         = 0;
+	size_t      input_count  = 0;
+	size_t      output_count = 0;
+	if (!(in >> magic >> version >> std::hex >> hash >> std::dec >> input_count >> output_count) ||
+	    magic != kManifestMagic || version != kManifestVersion || hash != model_hash ||
+	    input_count != inputs.size())
+	{
+		return false;
+	}
+
+	std::string line;
+	std::getline(in, line);
+	for (const auto &input : inputs)
+	{
+		TensorDesc desc;
+		if (!std::getline(in, line) || !readDesc(line, "input", desc) || !sameInput(desc, input))
+		{
+			return false;
+		}
+	}
+
+	std::vector<TensorDesc> loaded(output_count);
+	for (auto &desc : loaded)
+	{
+		if (!std::getline(in, line) || !readDesc(line, "output", desc))
+		{
+			return false;
+		}
+	}
+
+	outputs = std::move(loaded);
+	return true;
+}
+
+bool saveIoManifest(const std::string &manifest_path, uint64_t model_hash,
+                    const std::vector<TensorDesc> &inputs, const std::vector<TensorDesc> &outputs)
+{
+	const std::string tmp_path = manifest_path + ".tmp." + std::to_string(getpid());
+	{
+		std::ofstream out(tmp_path, std::ios::trunc);
+		if (!out)
+		{
+			return false;
+		}
+
+		out << kManifestMagic << ' ' << kManifestVersion << ' ' << std::hex << model_hash << std::dec << ' '
+		    << inputs.size() << ' ' << outputs.size() << '\n';
+		for (const auto &desc : inputs)
+		{
+			writeDesc(out, "input", desc);
+		}
+		for (const auto &desc : outputs)
+		{
+			writeDesc(out, "output", desc);
+		}
+
+		if (!out.flush())
+		{
+			std::remove(tmp_path.c_str());
+			return false;
+		}
+	}
+
+	if (std::rename(tmp_path.c_str(), manifest_path.c_str()) != 0)
+	{
+		std::remove(tmp_path.c_str());
+		return false;
+	}
+	return true;
+}
+}        // namespace gomang
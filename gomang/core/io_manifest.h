@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensor.h"
+
+namespace gomang
+{
+// 64-bit content hash for model files; chain calls through seed to cover
+// several files (e.g. ncnn .param and .bin).
+constexpr uint64_t kModelHashSeed = 0xcbf29ce484222325ull;
+
+uint64_t hashModelBytes(const void *data, size_t size, uint64_t seed = kModelHashSeed);
+
+// False if the file cannot be mapped.
+bool hashModelFile(const std::string &path, uint64_t &hash, uint64_t seed = kModelHashSeed);
+
+// Sidecar written next to the model on first load, so later loads can take
+// output descriptions from it instead of running a probe inference.
+std::string getIoManifestPath(const std::string &model_path);
+
+// Fills outputs only if the manifest exists, matches model_hash and was
+// recorded for the same input shapes, data types and layouts.
+bool loadIoManifest(const std::string &manifest_path, uint64_t model_hash,
+                    const std::vector<TensorDesc> &inputs, std::vector<TensorDesc> &outputs);
+
+// Written to a temporary file and renamed into place, so workers starting
+// together never read a partial manifest.
+bool saveIoManifest(const std::string &manifest_path, uint64_t model_hash,
+                    const std::vector<TensorDesc> &inputs, const std::vector<TensorDesc> &outputs);
+}        // namespace gomang
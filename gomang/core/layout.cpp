@@ -0,0 +1,544 @@
+#include "layout.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "parallel.h"
+#include "trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#	define GOMANG_LAYOUT_X86 1
+#	include <immintrin.h>
+#endif
+
+namespace gomang
+{
+namespace
+{
+enum class SimdLevel
+{
+	kScalar,
+	kAVX2,
+	kAVX512
+};
+
+SimdLevel getSimdLevel()
+{
+#ifdef GOMANG_LAYOUT_X86
+	static const SimdLevel level = [] {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return SimdLevel::kAVX512;
+		}
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return SimdLevel::kAVX2;
+		}
+		return SimdLevel::kScalar;
+	}();
+	return level;
+#else
+	return SimdLevel::kScalar;
+#endif
+}
+
+// dst[j * dst_stride + i] = src[i * src_stride + j], blocked for cache reuse.
+template <typename T>
+void transposeScalar(const T *src, size_t src_stride, T *dst, size_t dst_stride, size_t rows, size_t cols)
+{
+	constexpr size_t kBlock = 32;
+	for (size_t i0 = 0; i0 < rows; i0 += kBlock)
+	{
+		for (size_t j0 = 0; j0 < cols; j0 += kBlock)
+		{
+			const size_t i1 = std::min(rows, i0 + kBlock);
+			const size_t j1 = std::min(cols, j0 + kBlock);
+			for (size_t i = i0; i < i1; ++i)
+			{
+				for (size_t j = j0; j < j1; ++j)
+				{
+					dst[j * dst_stride + i] = src[i * src_stride + j];
+				}
+			}
+		}
+	}
+}
+
+// dst[hw * 4 + k] = rows[k][hw]; missing rows (nullptr) are zero-filled.
+template <typename T>
+void packC4Scalar(const T *const rows[4], T *dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (size_t k = 0; k < 4; ++k)
+		{
+			dst[i * 4 + k] = rows[k] ? rows[k][i] : T{0};
+		}
+	}
+}
+
+// rows[k][hw] = src[hw * 4 + k]; nullptr rows are skipped.
+template <typename T>
+void unpackC4Scalar(const T *src, T *const rows[4], size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (size_t k = 0; k < 4; ++k)
+		{
+			if (rows[k])
+			{
+				rows[k][i] = src[i * 4 + k];
+			}
+		}
+	}
+}
+
+#ifdef GOMANG_LAYOUT_X86
+__attribute__((target("avx2"))) inline void transpose8x8Avx2(const float *src, size_t src_stride, float *dst, size_t dst_stride)
+{
+	__m256 r0 = _mm256_loadu_ps(src + 0 * src_stride);
+	__m256 r1 = _mm256_loadu_ps(src + 1 * src_stride);
+	__m256 r2 = _mm256_loadu_ps(src + 2 * src_stride);
+	__m256 r3 = _mm256_loadu_ps(src + 3 * src_stride);
+	__m256 r4 = _mm256_loadu_ps(src + 4 * src_stride);
+	__m256 r5 = _mm256_loadu_ps(src + 5 * src_stride);
+	__m256 r6 = _mm256_loadu_ps(src + 6 * src_stride);
+	__m256 r7 = _mm256_loadu_ps(src + 7 * src_stride);
+
+	__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+	__m256 t1 = _mm256_unpackhi_ps(r0, r1);
+	__m256 t2 = _mm256_unpacklo_ps(r2, r3);
+	__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+	__m256 t4 = _mm256_unpacklo_ps(r4, r5);
+	__m256 t5 = _mm256_unpackhi_ps(r4, r5);
+	__m256 t6 = _mm256_unpacklo_ps(r6, r7);
+	__m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+	_mm256_storeu_ps(dst + 0 * dst_stride, _mm256_permute2f128_ps(s0, s4, 0x20));
+	_mm256_storeu_ps(dst + 1 * dst_stride, _mm256_permute2f128_ps(s1, s5, 0x20));
+	_mm256_storeu_ps(dst + 2 * dst_stride, _mm256_permute2f128_ps(s2, s6, 0x20));
+	_mm256_storeu_ps(dst + 3 * dst_stride, _mm256_permute2f128_ps(s3, s7, 0x20));
+	_mm256_storeu_ps(dst + 4 * dst_stride, _mm256_permute2f128_ps(s0, s4, 0x31));
+	_mm256_storeu_ps(dst + 5 * dst_stride, _mm256_permute2f128_ps(s1, s5, 0x31));
+	_mm256_storeu_ps(dst + 6 * dst_stride, _mm256_permute2f128_ps(s2, s6, 0x31));
+	_mm256_storeu_ps(dst + 7 * dst_stride, _mm256_permute2f128_ps(s3, s7, 0x31));
+}
+
+__attribute__((target("avx2"))) void transposeAvx2(const float *src, size_t src_stride, float *dst, size_t dst_stride, size_t rows, size_t cols)
+{
+	const size_t rows8 = rows & ~size_t(7);
+	const size_t cols8 = cols & ~size_t(7);
+	for (size_t i = 0; i < rows8; i += 8)
+	{
+		for (size_t j = 0; j < cols8; j += 8)
+		{
+			transpose8x8Avx2(src + i * src_stride + j, src_stride, dst + j * dst_stride + i, dst_stride);
+		}
+	}
+
+	transposeScalar(src + cols8, src_stride, dst + cols8 * dst_stride, dst_stride, rows, cols - cols8);
+	transposeScalar(src + rows8 * src_stride, src_stride, dst + rows8, dst_stride, rows - rows8, cols8);
+}
+
+// 4x4 transpose inside each 128-bit lane; used in both pack directions.
+__attribute__((target("avx2"))) inline void transpose4InLaneAvx2(__m256 &a, __m256 &b, __m256 &c, __m256 &d)
+{
+	__m256 t0 = _mm256_unpacklo_ps(a, b);
+	__m256 t1 = _mm256_unpacklo_ps(c, d);
+	__m256 t2 = _mm256_unpackhi_ps(a, b);
+	__m256 t3 = _mm256_unpackhi_ps(c, d);
+	a         = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	b         = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	c         = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	d         = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+__attribute__((target("avx2"))) void packC4Avx2(const float *const rows[4], float *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 r0 = _mm256_loadu_ps(rows[0] + i);
+		__m256 r1 = _mm256_loadu_ps(rows[1] + i);
+		__m256 r2 = _mm256_loadu_ps(rows[2] + i);
+		__m256 r3 = _mm256_loadu_ps(rows[3] + i);
+		transpose4InLaneAvx2(r0, r1, r2, r3);
+
+		float *out = dst + i * 4;
+		_mm256_storeu_ps(out + 0, _mm256_permute2f128_ps(r0, r1, 0x20));
+		_mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(r2, r3, 0x20));
+		_mm256_storeu_ps(out + 16, _mm256_permute2f128_ps(r0, r1, 0x31));
+		_mm256_storeu_ps(out + 24, _mm256_permute2f128_ps(r2, r3, 0x31));
+	}
+
+	const float *tail[4] = {rows[0] + i, rows[1] + i, rows[2] + i, rows[3] + i};
+	packC4Scalar(tail, dst + i * 4, count - i);
+}
+
+__attribute__((target("avx2"))) void unpackC4Avx2(const float *src, float *const rows[4], size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const float *in = src + i * 4;
+		__m256       o0 = _mm256_loadu_ps(in + 0);
+		__m256       o1 = _mm256_loadu_ps(in + 8);
+		__m256       o2 = _mm256_loadu_ps(in + 16);
+		__m256       o3 = _mm256_loadu_ps(in + 24);
+
+		__m256 r0 = _mm256_permute2f128_ps(o0, o2, 0x20);
+		__m256 r1 = _mm256_permute2f128_ps(o0, o2, 0x31);
+		__m256 r2 = _mm256_permute2f128_ps(o1, o3, 0x20);
+		__m256 r3 = _mm256_permute2f128_ps(o1, o3, 0x31);
+		transpose4InLaneAvx2(r0, r1, r2, r3);
+
+		_mm256_storeu_ps(rows[0] + i, r0);
+		_mm256_storeu_ps(rows[1] + i, r1);
+		_mm256_storeu_ps(rows[2] + i, r2);
+		_mm256_storeu_ps(rows[3] + i, r3);
+	}
+
+	float *tail[4] = {rows[0] + i, rows[1] + i, rows[2] + i, rows[3] + i};
+	unpackC4Scalar(src + i * 4, tail, count - i);
+}
+
+// Transposes the 4x4 grid of 128-bit lanes; it is its own inverse.
+__attribute__((target("avx512f"))) inline void transposeLanesAvx512(__m512 &a, __m512 &b, __m512 &c, __m512 &d)
+{
+	__m512 ab_lo = _mm512_shuffle_f32x4(a, b, _MM_SHUFFLE(1, 0, 1, 0));
+	__m512 cd_lo = _mm512_shuffle_f32x4(c, d, _MM_SHUFFLE(1, 0, 1, 0));
+	__m512 ab_hi = _mm512_shuffle_f32x4(a, b, _MM_SHUFFLE(3, 2, 3, 2));
+	__m512 cd_hi = _mm512_shuffle_f32x4(c, d, _MM_SHUFFLE(3, 2, 3, 2));
+	a            = _mm512_shuffle_f32x4(ab_lo, cd_lo, _MM_SHUFFLE(2, 0, 2, 0));
+	b            = _mm512_shuffle_f32x4(ab_lo, cd_lo, _MM_SHUFFLE(3, 1, 3, 1));
+	c            = _mm512_shuffle_f32x4(ab_hi, cd_hi, _MM_SHUFFLE(2, 0, 2, 0));
+	d            = _mm512_shuffle_f32x4(ab_hi, cd_hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+__attribute__((target("avx512f"))) inline void transpose4InLaneAvx512(__m512 &a, __m512 &b, __m512 &c, __m512 &d)
+{
+	__m512 t0 = _mm512_unpacklo_ps(a, b);
+	__m512 t1 = _mm512_unpacklo_ps(c, d);
+	__m512 t2 = _mm512_unpackhi_ps(a, b);
+	__m512 t3 = _mm512_unpackhi_ps(c, d);
+	a         = _mm512_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	b         = _mm512_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	c         = _mm512_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	d         = _mm512_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+__attribute__((target("avx512f"))) void packC4Avx512(const float *const rows[4], float *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512 r0 = _mm512_loadu_ps(rows[0] + i);
+		__m512 r1 = _mm512_loadu_ps(rows[1] + i);
+		__m512 r2 = _mm512_loadu_ps(rows[2] + i);
+		__m512 r3 = _mm512_loadu_ps(rows[3] + i);
+		transpose4InLaneAvx512(r0, r1, r2, r3);
+		transposeLanesAvx512(r0, r1, r2, r3);
+
+		float *out = dst + i * 4;
+		_mm512_storeu_ps(out + 0, r0);
+		_mm512_storeu_ps(out + 16, r1);
+		_mm512_storeu_ps(out + 32, r2);
+		_mm512_storeu_ps(out + 48, r3);
+	}
+
+	const float *tail[4] = {rows[0] + i, rows[1] + i, rows[2] + i, rows[3] + i};
+	packC4Avx2(tail, dst + i * 4, count - i);
+}
+
+__attribute__((target("avx512f"))) void unpackC4Avx512(const float *src, float *const rows[4], size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const float *in = src + i * 4;
+		__m512       r0 = _mm512_loadu_ps(in + 0);
+		__m512       r1 = _mm512_loadu_ps(in + 16);
+		__m512       r2 = _mm512_loadu_ps(in + 32);
+		__m512       r3 = _mm512_loadu_ps(in + 48);
+		transposeLanesAvx512(r0, r1, r2, r3);
+		transpose4InLaneAvx512(r0, r1, r2, r3);
+
+		_mm512_storeu_ps(rows[0] + i, r0);
+		_mm512_storeu_ps(rows[1] + i, r1);
+		_mm512_storeu_ps(rows[2] + i, r2);
+		_mm512_storeu_ps(rows[3] + i, r3);
+	}
+
+	float *tail[4] = {rows[0] + i, rows[1] + i, rows[2] + i, rows[3] + i};
+	unpackC4Avx2(src + i * 4, tail, count - i);
+}
+#endif
+
+template <typename T>
+void transpose(const T *src, size_t src_stride, T *dst, size_t dst_stride, size_t rows, size_t cols)
+{
+#ifdef GOMANG_LAYOUT_X86
+	if constexpr (sizeof(T) == 4)
+	{
+		if (getSimdLevel() != SimdLevel::kScalar)
+		{
+			transposeAvx2(reinterpret_cast<const float *>(src), src_stride,
+			              reinterpret_cast<float *>(dst), dst_stride, rows, cols);
+			return;
+		}
+	}
+#endif
+	transposeScalar(src, src_stride, dst, dst_stride, rows, cols);
+}
+
+template <typename T>
+void packC4(const T *const rows[4], T *dst, size_t count)
+{
+#ifdef GOMANG_LAYOUT_X86
+	if constexpr (sizeof(T) == 4)
+	{
+		if (rows[0] && rows[1] && rows[2] && rows[3])
+		{
+			const auto **frows = reinterpret_cast<const float **>(const_cast<const T **>(rows));
+			switch (getSimdLevel())
+			{
+				case SimdLevel::kAVX512:
+					packC4Avx512(frows, reinterpret_cast<float *>(dst), count);
+					return;
+				case SimdLevel::kAVX2:
+					packC4Avx2(frows, reinterpret_cast<float *>(dst), count);
+					return;
+				default:
+					break;
+			}
+		}
+	}
+#endif
+	packC4Scalar(rows, dst, count);
+}
+
+template <typename T>
+void unpackC4(const T *src, T *const rows[4], size_t count)
+{
+#ifdef GOMANG_LAYOUT_X86
+	if constexpr (sizeof(T) == 4)
+	{
+		if (rows[0] && rows[1] && rows[2] && rows[3])
+		{
+			auto **frows = reinterpret_cast<float **>(const_cast<T **>(rows));
+			switch (getSimdLevel())
+			{
+				case SimdLevel::kAVX512:
+					unpackC4Avx512(reinterpret_cast<const float *>(src), frows, count);
+					return;
+				case SimdLevel::kAVX2:
+					unpackC4Avx2(reinterpret_cast<const float *>(src), frows, count);
+					return;
+				default:
+					break;
+			}
+		}
+	}
+#endif
+	unpackC4Scalar(src, rows, count);
+}
+
+// Runs fn(batch, begin, end) over [0, n * extent) split across threads.
+void parallelOverBatch(int64_t n, size_t extent, unsigned int num_threads, size_t grain,
+                       const std::function<void(size_t, size_t, size_t)> &fn)
+{
+	parallelFor(0, static_cast<size_t>(n) * extent, num_threads, grain, [&](size_t begin, size_t end) {
+		while (begin < end)
+		{
+			size_t batch     = begin / extent;
+			size_t local     = begin % extent;
+			size_t local_end = std::min(extent, local + (end - begin));
+			fn(batch, local, local_end);
+			begin += local_end - local;
+		}
+	});
+}
+
+template <typename T>
+void convert(const T *src, MemoryLayout src_layout, T *dst, MemoryLayout dst_layout,
+             const ImageDims &dims, unsigned int num_threads)
+{
+	const size_t C  = dims.c;
+	const size_t HW = dims.h * dims.w;
+	const size_t C4 = (C + 3) / 4;
+
+	const size_t src_batch = src_layout == MemoryLayout::kNC4HW4 ? C4 * 4 * HW : C * HW;
+	const size_t dst_batch = dst_layout == MemoryLayout::kNC4HW4 ? C4 * 4 * HW : C * HW;
+
+	// Keep each task at a few KiB of output at least, so small tensors stay single threaded.
+	const size_t kMinTaskElements = 16384;
+
+	if (src_layout == MemoryLayout::kNCHW && dst_layout == MemoryLayout::kNHWC)
+	{
+		parallelOverBatch(dims.n, HW, num_threads, std::max<size_t>(kMinTaskElements / std::max<size_t>(C, 1), 8),
+		                  [&](size_t b, size_t begin, size_t end) {
+			                  transpose(src + b * src_batch + begin, HW, dst + b * dst_batch + begin * C, C, C, end - begin);
+		                  });
+	}
+	else if (src_layout == MemoryLayout::kNHWC && dst_layout == MemoryLayout::kNCHW)
+	{
+		parallelOverBatch(dims.n, C, num_threads, std::max<size_t>(kMinTaskElements / std::max<size_t>(HW, 1), 1),
+		                  [&](size_t b, size_t begin, size_t end) {
+			                  transpose(src + b * src_batch + begin, C, dst + b * dst_batch + begin * HW, HW, HW, end - begin);
+		                  });
+	}
+	else if (src_layout == MemoryLayout::kNCHW && dst_layout == MemoryLayout::kNC4HW4)
+	{
+		parallelOverBatch(dims.n, C4, num_threads, std::max<size_t>(kMinTaskElements / std::max<size_t>(HW * 4, 1), 1),
+		                  [&](size_t b, size_t begin, size_t end) {
+			                  for (size_t cb = begin; cb < end; ++cb)
+			                  {
+				                  const T *rows[4];
+				                  for (size_t k = 0; k < 4; ++k)
+				                  {
+					                  size_t c = cb * 4 + k;
+					                  rows[k]  = c < C ? src + b * src_batch + c * HW : nullptr;
+				                  }
+				                  packC4(rows, dst + b * dst_batch + cb * HW * 4, HW);
+			                  }
+		                  });
+	}
+	else if (src_layout == MemoryLayout::kNC4HW4 && dst_layout == MemoryLayout::kNCHW)
+	{
+		parallelOverBatch(dims.n, C4, num_threads, std::max<size_t>(kMinTaskElements / std::max<size_t>(HW * 4, 1), 1),
+		                  [&](size_t b, size_t begin, size_t end) {
+			                  for (size_t cb = begin; cb < end; ++cb)
+			                  {
+				                  T *rows[4];
+				                  for (size_t k = 0; k < 4; ++k)
+				                  {
+					                  size_t c = cb * 4 + k;
+					                  rows[k]  = c < C ? dst + b * dst_batch + c * HW : nullptr;
+				                  }
+				                  unpackC4(src + b * src_batch + cb * HW * 4, rows, HW);
+			                  }
+		                  });
+	}
+	else if (src_layout == MemoryLayout::kNHWC && dst_layout == MemoryLayout::kNC4HW4)
+	{
+		parallelOverBatch(dims.n, C4, num_threads, std::max<size_t>(kMinTaskElements / std::max<size_t>(HW * 4, 1), 1),
+		                  [&](size_t b, size_t begin, size_t end) {
+			                  const T *in = src + b * src_batch;
+			                  for (size_t cb = begin; cb < end; ++cb)
+			                  {
+				                  T           *out   = dst + b * dst_batch + cb * HW * 4;
+				                  const size_t valid = std::min<size_t>(4, C - cb * 4);
+				                  for (size_t hw = 0; hw < HW; ++hw)
+				                  {
+					                  for (size_t k = 0; k < 4; ++k)
+					                  {
+						                  out[hw * 4 + k] = k < valid ? in[hw * C + cb * 4 + k] : T{0};
+					                  }
+				                  }
+			                  }
+		                  });
+	}
+	else if (src_layout == MemoryLayout::kNC4HW4 && dst_layout == MemoryLayout::kNHWC)
+	{
+		parallelOverBatch(dims.n, HW, num_threads, std::max<size_t>(kMinTaskElements / std::max<size_t>(C, 1), 8),
+		                  [&](size_t b, size_t begin, size_t end) {
+			                  const T *in  = src + b * src_batch;
+			                  T       *out = dst + b * dst_batch;
+			                  for (size_t hw = begin; hw < end; ++hw)
+			                  {
+				                  for (size_t c = 0; c < C; ++c)
+				                  {
+					                  out[hw * C + c] = in[((c / 4) * HW + hw) * 4 + (c % 4)];
+				                  }
+			                  }
+		                  });
+	}
+	else
+	{
+		memcpy(dst, src, dims.n * src_batch * sizeof(T));
+	}
+}
+}        // namespace
+
+bool getImageDims(const TensorDesc &desc, ImageDims &dims)
+{
+	if (desc.shape.size() != 4)
+	{
+		return false;
+	}
+
+	if (desc.layout == MemoryLayout::kNHWC)
+	{
+		dims = {desc.shape[0], desc.shape[3], desc.shape[1], desc.shape[2]};
+	}
+	else
+	{
+		dims = {desc.shape[0], desc.shape[1], desc.shape[2], desc.shape[3]};
+	}
+	return true;
+}
+
+TensorDesc withLayout(const TensorDesc &desc, MemoryLayout layout)
+{
+	TensorDesc result = desc;
+	ImageDims  dims;
+	if (getImageDims(desc, dims))
+	{
+		result.shape = layout == MemoryLayout::kNHWC ? std::vector<int64_t>{dims.n, dims.h, dims.w, dims.c}
+		                                             : std::vector<int64_t>{dims.n, dims.c, dims.h, dims.w};
+	}
+	result.layout = layout;
+	return result;
+}
+
+bool convertLayout(const void *src, MemoryLayout src_layout,
+                   void *dst, MemoryLayout dst_layout,
+                   const ImageDims &dims, size_t element_size, unsigned int num_threads)
+{
+	GOMANG_TRACE_SCOPE("core", "layout_convert");
+
+	switch (element_size)
+	{
+		case 4:
+			convert(static_cast<const uint32_t *>(src), src_layout, static_cast<uint32_t *>(dst), dst_layout, dims, num_threads);
+			return true;
+		case 2:
+			convert(static_cast<const uint16_t *>(src), src_layout, static_cast<uint16_t *>(dst), dst_layout, dims, num_threads);
+			return true;
+		case 1:
+			convert(static_cast<const uint8_t *>(src), src_layout, static_cast<uint8_t *>(dst), dst_layout, dims, num_threads);
+			return true;
+		default:
+			std::cerr << "convertLayout: unsupported element size " << element_size << std::endl;
+			return false;
+	}
+}
+
+bool convertLayout(const void *src, const TensorDesc &src_desc,
+                   void *dst, const TensorDesc &dst_desc, unsigned int num_threads)
+{
+	ImageDims src_dims;
+	ImageDims dst_dims;
+	if (!getImageDims(src_desc, src_dims) || !getImageDims(dst_desc, dst_dims) ||
+	    src_dims.n != dst_dims.n || src_dims.c != dst_dims.c || src_dims.h != dst_dims.h || src_dims.w != dst_dims.w ||
+	    src_desc.data_type != dst_desc.data_type)
+	{
+		std::cerr << "convertLayout: tensors " << src_desc.name << " and " << dst_desc.name << " are not compatible" << std::endl;
+		return false;
+	}
+
+	return convertLayout(src, src_desc.layout, dst, dst_desc.layout, src_dims,
+	                     getDataTypeSize(src_desc.data_type), num_threads);
+}
+}        // namespace gomang
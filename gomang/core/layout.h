@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "tensor.h"
+
+namespace gomang
+{
+// Logical dimensions of a 4-D image tensor. TensorDesc::shape is [N, C, H, W]
+// for kNCHW and kNC4HW4 and [N, H, W, C] for kNHWC.
+struct ImageDims
+{
+	int64_t n{0};
+	int64_t c{0};
+	int64_t h{0};
+	int64_t w{0};
+};
+
+bool getImageDims(const TensorDesc &desc, ImageDims &dims);
+
+// Rewrites desc.shape for a different layout of the same logical tensor.
+TensorDesc withLayout(const TensorDesc &desc, MemoryLayout layout);
+
+// Converts between kNCHW, kNHWC and kNC4HW4 for 1, 2 and 4 byte elements.
+// kNC4HW4 pads channels up to a multiple of four with zeros. 4-byte elements
+// use AVX2/AVX-512 kernels when the CPU has them. Work is split over N and the
+// outer dimension of the destination. src and dst must not overlap.
+bool convertLayout(const void *src, MemoryLayout src_layout,
+                   void *dst, MemoryLayout dst_layout,
+                   const ImageDims &dims, size_t element_size, unsigned int num_threads = 1);
+
+// Same, taking layouts, dims and element size from the descriptors, which
+// must agree on data type and logical dimensions.
+bool convertLayout(const void *src, const TensorDesc &src_desc,
+                   void *dst, const TensorDesc &dst_desc, unsigned int num_threads = 1);
+}        // namespace gomang
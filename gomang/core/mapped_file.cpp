@@ -0,0 +1,102 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gomang
+{
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+    data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)),
+    error_(std::move(other.error_))
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		data_  = std::exchange(other.data_, nullptr);
+		size_  = std::exchange(other.size_, 0);
+		error_ = std::move(other.error_);
+	}
+	return *this;
+}
+
+bool MappedFile::open(const std::string &path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		error_ = "Failed to open " + path + ": " + std::strerror(errno);
+		return false;
+	}
+
+	struct stat st{};
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		error_ = "Failed to stat " + path + " or file is empty";
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping keeps its own reference to the file.
+	const int mmap_errno = errno;
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		error_ = "Failed to mmap " + path + ": " + std::strerror(mmap_errno);
+		return false;
+	}
+
+	error_.clear();
+	data_ = data;
+	size_ = static_cast<size_t>(st.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_)
+	{
+		munmap(data_, size_);
+		data_ = nullptr;
+		size_ = 0;
+	}
+}
+
+bool MappedFile::isOpen() const
+{
+	return data_ != nullptr;
+}
+
+const uint8_t *MappedFile::data() const
+{
+	return static_cast<const uint8_t *>(data_);
+}
+
+size_t MappedFile::size() const
+{
+	return size_;
+}
+
+const std::string &MappedFile::getError() const
+{
+	return error_;
+}
+}        // namespace gomang
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gomang
+{
+// Read-only memory mapping of a whole file. Pages come from the page cache,
+// so processes mapping the same file share them and nothing is copied.
+class MappedFile
+{
+  public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(MappedFile &&other) noexcept;
+	MappedFile &operator=(MappedFile &&other) noexcept;
+
+	MappedFile(const MappedFile &)            = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// Does not log: callers that have a fallback stay quiet, the others report
+	// getError().
+	bool open(const std::string &path);
+	void close();
+
+	[[nodiscard]] bool           isOpen() const;
+	[[nodiscard]] const uint8_t *data() const;
+	[[nodiscard]] size_t         size() const;
+
+	// Why the last open() failed; empty after a successful one.
+	[[nodiscard]] const std::string &getError() const;
+
+  private:
+	void       *data_{nullptr};
+	size_t      size_{0};
+	std::string error_;
+};
+}        // namespace gomang
@@ -20,6 +20,7 @@ enum class DataType
 {
 	kFLOAT32,
 	kFLOAT16,
+	kBFLOAT16,
 	kINT8,
 	kINT32
 };
@@ -31,6 +32,7 @@ inline size_t getDataTypeSize(DataType type)
 		case DataType::kFLOAT32:
 			return 4;
 		case DataType::kFLOAT16:
+		case DataType::kBFLOAT16:
 			return 2;
 		case DataType::kINT8:
 			return 1;
@@ -49,6 +51,8 @@ inline const char *getDataTypeName(const DataType type)
 			return "FLOAT32";
 		case DataType::kFLOAT16:
 			return "FLOAT16";
+		case DataType::kBFLOAT16:
+			return "BFLOAT16";
 		case DataType::kINT8:
 			return "INT8";
 		case DataType::kINT32:
@@ -66,6 +70,8 @@ inline const char *getMemoryLayoutName(const MemoryLayout layout)
 			return "NHWC";
 		case MemoryLayout::kNCHW:
 			return "NCHW";
+		case MemoryLayout::kNC4HW4:
+			return "NC4HW4";
 		default:
 			return "UNKNOWN";
 	}
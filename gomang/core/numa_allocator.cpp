@@ -0,0 +1,210 @@
+#include "numa_allocator.h"
+
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace gomang
+{
+namespace
+{
+// Default huge page size on x86-64 and on arm64 with 4 KiB base pages.
+constexpr size_t kHugePageSize = 2ull << 20;
+
+// From <linux/mempolicy.h>, which not every libc ships.
+constexpr int kMpolBind = 2;
+
+size_t roundUp(size_t size, size_t multiple)
+{
+	return (size + multiple - 1) / multiple * multiple;
+}
+
+// Anonymous mapping of length bytes starting on a huge page boundary, so the
+// kernel can back all of it with huge pages rather than just the aligned middle.
+void *mapAligned(size_t length)
+{
+	const size_t padded = length + kHugePageSize;
+	void        *raw    = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+	const auto address = reinterpret_cast<uintptr_t>(raw);
+	const auto aligned = roundUp(address, kHugePageSize);
+	if (aligned > address)
+	{
+		munmap(raw, aligned - address);
+	}
+	if (const size_t tail = address + padded - (aligned + length); tail > 0)
+	{
+		munmap(reinterpret_cast<void *>(aligned + length), tail);
+	}
+	return reinterpret_cast<void *>(aligned);
+}
+}        // namespace
+
+NumaAllocator::NumaAllocator(NumaAllocatorOptions options) :
+    options_(options)
+{
+	options_.alignment = std::bit_ceil(options_.alignment);
+
+	if (options_.node >= getNumNodes())
+	{
+		std::cerr << "NumaAllocator: node " << options_.node << " does not exist; using first-touch placement"
+		          << std::endl;
+		options_.node = -1;
+	}
+}
+
+NumaAllocator::~NumaAllocator()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!mappings_.empty())
+	{
+		std::cerr << "NumaAllocator: " << mappings_.size() << " blocks still allocated" << std::endl;
+	}
+	for (const auto &[ptr, length] : mappings_)
+	{
+		munmap(ptr, length);
+	}
+}
+
+void *NumaAllocator::allocate(size_t size, MemoryType type)
+{
+	if (type == MemoryType::kGPU)
+	{
+		std::cerr << "NumaAllocator: only host memory is supported" << std::endl;
+		return nullptr;
+	}
+
+	if (size < options_.min_mapped_bytes)
+	{
+		return std::aligned_alloc(options_.alignment, roundUp(size, options_.alignment));
+	}
+
+	size_t length = 0;
+	void  *ptr    = mapBlock(size, length);
+	if (!ptr)
+	{
+		return nullptr;
+	}
+	bindBlock(ptr, length);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	mappings_.emplace(ptr, length);
+	return ptr;
+}
+
+void NumaAllocator::deallocate(void *ptr, [[maybe_unused]] MemoryType type)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto                        it = mappings_.find(ptr);
+		if (it != mappings_.end())
+		{
+			munmap(ptr, it->second);
+			mappings_.erase(it);
+			return;
+		}
+	}
+	std::free(ptr);
+}
+
+const NumaAllocatorOptions &NumaAllocator::getOptions() const
+{
+	return options_;
+}
+
+int NumaAllocator::getNumNodes()
+{
+	std::error_code ec;
+	int             count = 0;
+	for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec))
+	{
+		const std::string name = entry.path().filename().string();
+		if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit(static_cast<unsigned char>(name[4])))
+		{
+			++count;
+		}
+	}
+	return count > 0 ? count : 1;
+}
+
+int NumaAllocator::getCurrentNode()
+{
+	unsigned int cpu  = 0;
+	unsigned int node = 0;
+	if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+	{
+		return -1;
+	}
+	return static_cast<int>(node);
+}
+
+void *NumaAllocator::mapBlock(size_t size, size_t &length) const
+{
+	if (options_.huge_pages == HugePages::kExplicit)
+	{
+		// Fails when no huge pages are reserved (vm.nr_hugepages); not worth a warning.
+		length    = roundUp(size, kHugePageSize);
+		void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (ptr != MAP_FAILED)
+		{
+			return ptr;
+		}
+	}
+
+	if (options_.huge_pages == HugePages::kNone)
+	{
+		length    = roundUp(size, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+		void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return ptr == MAP_FAILED ? nullptr : ptr;
+	}
+
+	length    = roundUp(size, kHugePageSize);
+	void *ptr = mapAligned(length);
+	if (ptr)
+	{
+		// Only advisory: with THP set to "never" this is a no-op, not an error.
+		madvise(ptr, length, MADV_HUGEPAGE);
+	}
+	return ptr;
+}
+
+void NumaAllocator::bindBlock(void *ptr, size_t length) const
+{
+	if (options_.node < 0 || !bind_enabled_.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	// Pages are not touched yet, so binding decides where they are faulted in.
+	constexpr size_t           kBitsPerWord = sizeof(unsigned long) * 8;
+	const auto                 node         = static_cast<size_t>(options_.node);
+	std::vector<unsigned long> node_mask(node / kBitsPerWord + 1, 0);
+	node_mask[node / kBitsPerWord] |= 1ul << (node % kBitsPerWord);
+
+	if (syscall(SYS_mbind, ptr, length, kMpolBind, node_mask.data(), node_mask.size() * kBitsPerWord + 1, 0) != 0 &&
+	    bind_enabled_.exchange(false))
+	{
+		std::cerr << "NumaAllocator: mbind to node " << options_.node << " failed (" << std::strerror(errno)
+		          << "); using first-touch placement" << std::endl;
+	}
+}
+}        // namespace gomang
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+#include "memory.h"
+
+namespace gomang
+{
+enum class HugePages
+{
+	kNone,
+	kTransparent,        // madvise(MADV_HUGEPAGE); the kernel promotes when it can
+	kExplicit            // MAP_HUGETLB from the reserved pool, kTransparent if it is empty
+};
+
+struct NumaAllocatorOptions
+{
+	// Node the pages are bound to (mbind MPOL_BIND); -1 leaves placement to
+	// first touch.
+	int node{-1};
+
+	HugePages huge_pages{HugePages::kTransparent};
+
+	// Smaller blocks come from std::aligned_alloc: mapping them would waste most
+	// of a page, and binding would move whatever else shares that page.
+	size_t min_mapped_bytes{256ull << 10};
+
+	size_t alignment{64};
+};
+
+// Host allocator for large tensors on multi-socket machines: blocks of at
+// least min_mapped_bytes are mmap'ed, bound to the chosen node and backed by
+// huge pages. Each step degrades on its own when the kernel refuses it (no
+// NUMA support, no huge pages), so the allocator always returns usable memory.
+// Pass it as EngineOptions::host_allocator to place an engine's buffers.
+class NumaAllocator : public IMemoryAllocator
+{
+  public:
+	explicit NumaAllocator(NumaAllocatorOptions options = {});
+
+	~NumaAllocator() override;
+
+	NumaAllocator(const NumaAllocator &)            = delete;
+	NumaAllocator &operator=(const NumaAllocator &) = delete;
+
+	void *allocate(size_t size, MemoryType type) override;
+	void  deallocate(void *ptr, MemoryType type) override;
+
+	[[nodiscard]] const NumaAllocatorOptions &getOptions() const;
+
+	// Nodes listed in /sys/devices/system/node; 1 on machines without NUMA.
+	static int getNumNodes();
+
+	// Node of the CPU the calling thread runs on, or -1 if unknown.
+	static int getCurrentNode();
+
+  private:
+	NumaAllocatorOptions options_;
+
+	std::mutex                         mutex_;
+	std::unordered_map<void *, size_t> mappings_;        // mmap'ed block -> length
+
+	// Cleared after the first mbind failure so it is reported once.
+	mutable std::atomic<bool> bind_enabled_{true};
+
+	void *mapBlock(size_t size, size_t &length) const;
+	void  bindBlock(void *ptr, size_t length) const;
+};
+}        // namespace gomang
@@ -0,0 +1,153 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gomang
+{
+namespace
+{
+// Process-wide workers shared by every parallelFor call, started on first use
+// and grown up to the largest chunk count requested (capped at the hardware
+// thread count). A caller waiting for its chunks runs queued chunks itself,
+// so nested or concurrent calls cannot starve each other.
+class WorkerPool
+{
+  public:
+	static WorkerPool &get()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		work_cv_.notify_all();
+		for (auto &worker : workers_)
+		{
+			worker.join();
+		}
+	}
+
+	// Runs fn(0) on the calling thread and fn(1) ... fn(count - 1) on workers.
+	void run(size_t count, const std::function<void(size_t)> &fn)
+	{
+		size_t remaining = count - 1;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			startWorkers(count - 1);
+			for (size_t i = 1; i < count; ++i)
+			{
+				tasks_.push_back({&fn, i, &remaining});
+			}
+		}
+		work_cv_.notify_all();
+		done_cv_.notify_all();
+
+		fn(0);
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (remaining > 0)
+		{
+			if (!tasks_.empty())
+			{
+				execute(lock);
+			}
+			else
+			{
+				done_cv_.wait(lock);
+			}
+		}
+	}
+
+  private:
+	struct Task
+	{
+		const std::function<void(size_t)> *fn;
+		size_t                             index;
+		size_t                            *remaining;
+	};
+
+	std::mutex               mutex_;
+	std::condition_variable  work_cv_;        // workers: tasks queued or stopping
+	std::condition_variable  done_cv_;        // callers: a task finished or was queued
+	std::deque<Task>         tasks_;
+	std::vector<std::thread> workers_;
+	bool                     stopping_{false};
+
+	void startWorkers(size_t count)
+	{
+		const size_t limit = std::min<size_t>(count, std::max(std::thread::hardware_concurrency(), 1u));
+		while (workers_.size() < limit)
+		{
+			workers_.emplace_back([this] { workerLoop(); });
+		}
+	}
+
+	void workerLoop()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true)
+		{
+			work_cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+			if (tasks_.empty())
+			{
+				return;
+			}
+			execute(lock);
+		}
+	}
+
+	// Pops and runs one task with the lock released; lock is held on return.
+	void execute(std::unique_lock<std::mutex> &lock)
+	{
+		const Task task = tasks_.front();
+		tasks_.pop_front();
+		lock.unlock();
+
+		(*task.fn)(task.index);
+
+		lock.lock();
+		--*task.remaining;
+		done_cv_.notify_all();
+	}
+};
+}        // namespace
+
+void parallelFor(size_t begin, size_t end, unsigned int num_threads, size_t grain,
+                 const std::function<void(size_t, size_t)> &fn)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	const size_t total      = end - begin;
+	const size_t max_chunks = (total + std::max<size_t>(grain, 1) - 1) / std::max<size_t>(grain, 1);
+	const size_t num_chunks = std::clamp<size_t>(num_threads, 1, max_chunks);
+	if (num_chunks == 1)
+	{
+		fn(begin, end);
+		return;
+	}
+
+	const size_t chunk = (total + num_chunks - 1) / num_chunks;
+
+	WorkerPool::get().run(num_chunks, [&](size_t i) {
+		size_t chunk_begin = begin + i * chunk;
+		size_t chunk_end   = std::min(end, chunk_begin + chunk);
+		if (chunk_begin < chunk_end)
+		{
+			fn(chunk_begin, chunk_end);
+		}
+	});
+}
+}        // namespace gomang
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace gomang
+{
+// Splits [begin, end) into contiguous chunks of at least grain items and runs
+// fn(chunk_begin, chunk_end) on up to num_threads threads; the calling thread
+// takes the first chunk and the rest go to a persistent worker pool, so the
+// per-call cost is a queue push rather than thread creation.
+void parallelFor(size_t begin, size_t end, unsigned int num_threads, size_t grain,
+                 const std::function<void(size_t, size_t)> &fn);
+}        // namespace gomang
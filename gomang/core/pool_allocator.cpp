@@ -0,0 +1,186 @@
+#include "pool_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+
+namespace gomang
+{
+PoolAllocator::PoolAllocator(IMemoryAllocator *upstream, size_t max_cached_bytes, size_t alignment) :
+    upstream_(upstream),
+    max_cached_bytes_(max_cached_bytes),
+    alignment_(std::bit_ceil(alignment))
+{
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	trimLocked(0);
+}
+
+void *PoolAllocator::allocate(size_t size, MemoryType type)
+{
+	const size_t size_class = getSizeClass(size);
+	auto        &pool       = pools_[static_cast<size_t>(type)];
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto                        it = pool.free_blocks.find(size_class);
+		if (it != pool.free_blocks.end() && !it->second.empty())
+		{
+			void *ptr = it->second.back();
+			it->second.pop_back();
+			cached_bytes_ -= size_class;
+			live_bytes_ += size_class;
+			high_water_bytes_ = std::max(high_water_bytes_, live_bytes_ + cached_bytes_);
+			pool.live_blocks.emplace(ptr, size_class);
+			return ptr;
+		}
+	}
+
+	void *ptr = allocateUpstream(size_class, type);
+	if (!ptr)
+	{
+		// Cached blocks of other classes may be what stands between us and success.
+		trim(0);
+		ptr = allocateUpstream(size_class, type);
+		if (!ptr)
+		{
+			return nullptr;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	live_bytes_ += size_class;
+	high_water_bytes_ = std::max(high_water_bytes_, live_bytes_ + cached_bytes_);
+	pool.live_blocks.emplace(ptr, size_class);
+	return ptr;
+}
+
+void PoolAllocator::deallocate(void *ptr, MemoryType type)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	auto &pool = pools_[static_cast<size_t>(type)];
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	auto                         it = pool.live_blocks.find(ptr);
+	if (it == pool.live_blocks.end())
+	{
+		std::cerr << "PoolAllocator: deallocating unknown pointer" << std::endl;
+		return;
+	}
+
+	const size_t size_class = it->second;
+	pool.live_blocks.erase(it);
+	live_bytes_ -= size_class;
+
+	if (cached_bytes_ + size_class > max_cached_bytes_)
+	{
+		lock.unlock();
+		deallocateUpstream(ptr, type);
+		return;
+	}
+
+	pool.free_blocks[size_class].push_back(ptr);
+	cached_bytes_ += size_class;
+}
+
+void PoolAllocator::trim(size_t target_bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	trimLocked(target_bytes);
+}
+
+void PoolAllocator::setMaxCachedBytes(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	max_cached_bytes_ = bytes;
+	trimLocked(bytes);
+}
+
+size_t PoolAllocator::getMaxCachedBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return max_cached_bytes_;
+}
+
+size_t PoolAllocator::getCachedBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return cached_bytes_;
+}
+
+size_t PoolAllocator::getLiveBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return live_bytes_;
+}
+
+size_t PoolAllocator::getHighWaterBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return high_water_bytes_;
+}
+
+size_t PoolAllocator::getSizeClass(size_t size) const
+{
+	if (size <= alignment_)
+	{
+		return alignment_;
+	}
+
+	// Split every power of two into four classes, bounding waste to 25%.
+	const size_t pow2 = std::bit_floor(size);
+	const size_t step = std::max(pow2 / 4, alignment_);
+	return (size + step - 1) / step * step;
+}
+
+void *PoolAllocator::allocateUpstream(size_t size, MemoryType type) const
+{
+	if (upstream_)
+	{
+		return upstream_->allocate(size, type);
+	}
+
+	if (type == MemoryType::kGPU)
+	{
+		std::cerr << "PoolAllocator: GPU memory requires an upstream allocator" << std::endl;
+		return nullptr;
+	}
+	return std::aligned_alloc(alignment_, size);
+}
+
+void PoolAllocator::deallocateUpstream(void *ptr, MemoryType type) const
+{
+	if (upstream_)
+	{
+		upstream_->deallocate(ptr, type);
+	}
+	else
+	{
+		std::free(ptr);
+	}
+}
+
+void PoolAllocator::trimLocked(size_t target_bytes)
+{
+	for (size_t i = 0; i < kNumMemoryTypes && cached_bytes_ > target_bytes; ++i)
+	{
+		for (auto &[size_class, blocks] : pools_[i].free_blocks)
+		{
+			while (!blocks.empty() && cached_bytes_ > target_bytes)
+			{
+				deallocateUpstream(blocks.back(), static_cast<MemoryType>(i));
+				blocks.pop_back();
+				cached_bytes_ -= size_class;
+			}
+		}
+	}
+}
+}        // namespace gomang
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "memory.h"
+
+namespace gomang
+{
+// Caching allocator that serves aligned blocks from size-classed free lists.
+// Freed blocks are kept for reuse until the cache reaches max_cached_bytes;
+// anything above that goes straight back to the upstream allocator.
+class PoolAllocator : public IMemoryAllocator
+{
+  public:
+	// upstream == nullptr falls back to std::aligned_alloc for host memory types.
+	explicit PoolAllocator(IMemoryAllocator *upstream        = nullptr,
+	                       size_t            max_cached_bytes = 256ull << 20,
+	                       size_t            alignment        = 64);
+
+	~PoolAllocator() override;
+
+	PoolAllocator(const PoolAllocator &)            = delete;
+	PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+	void *allocate(size_t size, MemoryType type) override;
+	void  deallocate(void *ptr, MemoryType type) override;
+
+	// Releases cached blocks until at most target_bytes stay cached.
+	void trim(size_t target_bytes = 0);
+
+	void setMaxCachedBytes(size_t bytes);
+
+	[[nodiscard]] size_t getMaxCachedBytes() const;
+	[[nodiscard]] size_t getCachedBytes() const;
+	[[nodiscard]] size_t getLiveBytes() const;
+	[[nodiscard]] size_t getHighWaterBytes() const;
+
+	// Rounds size up to its class: four classes per power of two, at least alignment.
+	[[nodiscard]] size_t getSizeClass(size_t size) const;
+
+  private:
+	static constexpr size_t kNumMemoryTypes = 3;
+
+	struct Pool
+	{
+		std::unordered_map<size_t, std::vector<void *>> free_blocks;        // size class -> cached blocks
+		std::unordered_map<void *, size_t>              live_blocks;        // block -> size class
+	};
+
+	IMemoryAllocator *upstream_;
+	size_t            max_cached_bytes_;
+	size_t            alignment_;
+
+	mutable std::mutex                mutex_;
+	std::array<Pool, kNumMemoryTypes> pools_;
+	size_t                            cached_bytes_{0};
+	size_t                            live_bytes_{0};
+	size_t                            high_water_bytes_{0};
+
+	void *allocateUpstream(size_t size, MemoryType type) const;
+	void  deallocateUpstream(void *ptr, MemoryType type) const;
+
+	void trimLocked(size_t target_bytes);
+};
+}        // namespace gomang
@@ -0,0 +1,414 @@
+#include "precision.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "parallel.h"
+#include "trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#	define GOMANG_PRECISION_X86 1
+#	include <immintrin.h>
+#endif
+
+namespace gomang
+{
+namespace
+{
+struct CpuFeatures
+{
+	bool f16c{false};
+	bool avx2{false};
+	bool avx512f{false};
+	bool avx512bf16{false};
+};
+
+const CpuFeatures &getCpuFeatures()
+{
+	static const CpuFeatures features = [] {
+		CpuFeatures result;
+#ifdef GOMANG_PRECISION_X86
+		__builtin_cpu_init();
+		result.f16c       = __builtin_cpu_supports("f16c");
+		result.avx2       = __builtin_cpu_supports("avx2");
+		result.avx512f    = __builtin_cpu_supports("avx512f");
+		result.avx512bf16 = result.avx512f && __builtin_cpu_supports("avx512bf16");
+#endif
+		return result;
+	}();
+	return features;
+}
+
+uint32_t floatBits(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+float bitsFloat(uint32_t bits)
+{
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void halfToFloatScalar(const uint16_t *src, float *dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		dst[i] = halfToFloat(src[i]);
+	}
+}
+
+void floatToHalfScalar(const float *src, uint16_t *dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		dst[i] = floatToHalf(src[i]);
+	}
+}
+
+void bfloat16ToFloatScalar(const uint16_t *src, float *dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		dst[i] = bfloat16ToFloat(src[i]);
+	}
+}
+
+void floatToBfloat16Scalar(const float *src, uint16_t *dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		dst[i] = floatToBfloat16(src[i]);
+	}
+}
+
+#ifdef GOMANG_PRECISION_X86
+__attribute__((target("avx,f16c"))) void halfToFloatF16c(const uint16_t *src, float *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+	}
+	halfToFloatScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx,f16c"))) void floatToHalfF16c(const float *src, uint16_t *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+	}
+	floatToHalfScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f"))) void halfToFloatAvx512(const uint16_t *src, float *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		_mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+	}
+	halfToFloatF16c(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f"))) void floatToHalfAvx512(const float *src, uint16_t *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), h);
+	}
+	floatToHalfF16c(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) void bfloat16ToFloatAvx2(const uint16_t *src, float *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_slli_epi32(x, 16));
+	}
+	bfloat16ToFloatScalar(src + i, dst + i, count - i);
+}
+
+// Integer round-to-nearest-even, same as floatToBfloat16().
+__attribute__((target("avx2"))) void floatToBfloat16Avx2(const float *src, uint16_t *dst, size_t count)
+{
+	const __m256i one      = _mm256_set1_epi32(1);
+	const __m256i bias     = _mm256_set1_epi32(0x7FFF);
+	const __m256i abs_mask = _mm256_set1_epi32(0x7FFFFFFF);
+	const __m256i inf      = _mm256_set1_epi32(0x7F800000);
+	const __m256i quiet    = _mm256_set1_epi32(0x00400000);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i x       = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		__m256i lsb     = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+		__m256i rounded = _mm256_add_epi32(x, _mm256_add_epi32(bias, lsb));
+		__m256i is_nan  = _mm256_cmpgt_epi32(_mm256_and_si256(x, abs_mask), inf);
+		__m256i result  = _mm256_srli_epi32(_mm256_blendv_epi8(rounded, _mm256_or_si256(x, quiet), is_nan), 16);
+
+		// packus works per 128-bit lane; gather the two low halves afterwards.
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(result, result), 0xD8);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm256_castsi256_si128(packed));
+	}
+	floatToBfloat16Scalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f"))) void bfloat16ToFloatAvx512(const uint16_t *src, float *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512i x = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)));
+		_mm512_storeu_si512(dst + i, _mm512_slli_epi32(x, 16));
+	}
+	bfloat16ToFloatAvx2(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f,avx512bf16"))) void floatToBfloat16Avx512Bf16(const float *src, uint16_t *dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+		std::memcpy(dst + i, &h, sizeof(h));
+	}
+	floatToBfloat16Avx2(src + i, dst + i, count - i);
+}
+#endif
+
+bool isFloatType(DataType type)
+{
+	return type == DataType::kFLOAT32 || type == DataType::kFLOAT16 || type == DataType::kBFLOAT16;
+}
+
+// Converts [begin, end) of a float-family buffer. Half <-> bfloat16 goes
+// through a small fp32 buffer on the stack.
+void convertRange(const void *src, DataType src_type, void *dst, DataType dst_type, size_t begin, size_t end)
+{
+	const auto *src16 = static_cast<const uint16_t *>(src);
+	const auto *src32 = static_cast<const float *>(src);
+	auto       *dst16 = static_cast<uint16_t *>(dst);
+	auto       *dst32 = static_cast<float *>(dst);
+
+	if (src_type == DataType::kFLOAT32)
+	{
+		if (dst_type == DataType::kFLOAT16)
+		{
+			floatToHalfArray(src32 + begin, dst16 + begin, end - begin);
+		}
+		else
+		{
+			floatToBfloat16Array(src32 + begin, dst16 + begin, end - begin);
+		}
+		return;
+	}
+
+	if (dst_type == DataType::kFLOAT32)
+	{
+		if (src_type == DataType::kFLOAT16)
+		{
+			halfToFloatArray(src16 + begin, dst32 + begin, end - begin);
+		}
+		else
+		{
+			bfloat16ToFloatArray(src16 + begin, dst32 + begin, end - begin);
+		}
+		return;
+	}
+
+	constexpr size_t kChunk = 1024;
+	float            scratch[kChunk];
+	for (size_t i = begin; i < end; i += kChunk)
+	{
+		size_t n = std::min(kChunk, end - i);
+		if (src_type == DataType::kFLOAT16)
+		{
+			halfToFloatArray(src16 + i, scratch, n);
+			floatToBfloat16Array(scratch, dst16 + i, n);
+		}
+		else
+		{
+			bfloat16ToFloatArray(src16 + i, scratch, n);
+			floatToHalfArray(scratch, dst16 + i, n);
+		}
+	}
+}
+}        // namespace
+
+uint16_t floatToHalf(float value)
+{
+	uint32_t       bits = floatBits(value);
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t       abs  = bits & 0x7FFFFFFF;
+
+	if (abs >= 0x7F800000)
+	{
+		// Inf stays Inf; NaN keeps its top payload bits and is forced quiet.
+		return sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 | ((abs >> 13) & 0x3FF) : 0);
+	}
+	if (abs >= 0x477FF000)
+	{
+		// 65520 and above round to Inf.
+		return sign | 0x7C00;
+	}
+	if (abs < 0x38800000)
+	{
+		// Below 2^-14 the result is subnormal: adding 0.5f lines the mantissa up so
+		// the FPU does the rounding.
+		constexpr uint32_t kDenormMagic = 126u << 23;
+		uint32_t           rounded      = floatBits(bitsFloat(abs) + bitsFloat(kDenormMagic)) - kDenormMagic;
+		return static_cast<uint16_t>(sign | rounded);
+	}
+
+	const uint32_t mant_odd = (abs >> 13) & 1;
+	abs                     = abs - (112u << 23) + 0xFFF + mant_odd;
+	return static_cast<uint16_t>(sign | (abs >> 13));
+}
+
+float halfToFloat(uint16_t value)
+{
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	const uint32_t exp  = (value >> 10) & 0x1F;
+	const uint32_t mant = value & 0x3FF;
+
+	if (exp == 0)
+	{
+		// Zero or subnormal: mant * 2^-24.
+		return bitsFloat(sign | floatBits(static_cast<float>(mant) * 5.9604644775390625e-8f));
+	}
+	if (exp == 0x1F)
+	{
+		return bitsFloat(sign | 0x7F800000 | (mant << 13));
+	}
+	return bitsFloat(sign | ((exp + 112) << 23) | (mant << 13));
+}
+
+uint16_t floatToBfloat16(float value)
+{
+	uint32_t bits = floatBits(value);
+	if ((bits & 0x7FFFFFFF) > 0x7F800000)
+	{
+		return static_cast<uint16_t>((bits >> 16) | 0x40);
+	}
+	bits += 0x7FFF + ((bits >> 16) & 1);
+	return static_cast<uint16_t>(bits >> 16);
+}
+
+float bfloat16ToFloat(uint16_t value)
+{
+	return bitsFloat(static_cast<uint32_t>(value) << 16);
+}
+
+void halfToFloatArray(const uint16_t *src, float *dst, size_t count)
+{
+#ifdef GOMANG_PRECISION_X86
+	const auto &cpu = getCpuFeatures();
+	if (cpu.avx512f)
+	{
+		halfToFloatAvx512(src, dst, count);
+		return;
+	}
+	if (cpu.f16c)
+	{
+		halfToFloatF16c(src, dst, count);
+		return;
+	}
+#endif
+	halfToFloatScalar(src, dst, count);
+}
+
+void floatToHalfArray(const float *src, uint16_t *dst, size_t count)
+{
+#ifdef GOMANG_PRECISION_X86
+	const auto &cpu = getCpuFeatures();
+	if (cpu.avx512f)
+	{
+		floatToHalfAvx512(src, dst, count);
+		return;
+	}
+	if (cpu.f16c)
+	{
+		floatToHalfF16c(src, dst, count);
+		return;
+	}
+#endif
+	floatToHalfScalar(src, dst, count);
+}
+
+void bfloat16ToFloatArray(const uint16_t *src, float *dst, size_t count)
+{
+#ifdef GOMANG_PRECISION_X86
+	const auto &cpu = getCpuFeatures();
+	if (cpu.avx512f)
+	{
+		bfloat16ToFloatAvx512(src, dst, count);
+		return;
+	}
+	if (cpu.avx2)
+	{
+		bfloat16ToFloatAvx2(src, dst, count);
+		return;
+	}
+#endif
+	bfloat16ToFloatScalar(src, dst, count);
+}
+
+void floatToBfloat16Array(const float *src, uint16_t *dst, size_t count)
+{
+#ifdef GOMANG_PRECISION_X86
+	const auto &cpu = getCpuFeatures();
+	if (cpu.avx512bf16)
+	{
+		floatToBfloat16Avx512Bf16(src, dst, count);
+		return;
+	}
+	if (cpu.avx2)
+	{
+		floatToBfloat16Avx2(src, dst, count);
+		return;
+	}
+#endif
+	floatToBfloat16Scalar(src, dst, count);
+}
+
+bool convertDataType(const void *src, DataType src_type,
+                     void *dst, DataType dst_type,
+                     size_t count, unsigned int num_threads)
+{
+	GOMANG_TRACE_SCOPE("core", "precision_convert");
+
+	if (src_type == dst_type)
+	{
+		std::memcpy(dst, src, count * getDataTypeSize(src_type));
+		return true;
+	}
+
+	if (!isFloatType(src_type) || !isFloatType(dst_type))
+	{
+		std::cerr << "Unsupported data type conversion: " << getDataTypeName(src_type)
+		          << " -> " << getDataTypeName(dst_type) << std::endl;
+		return false;
+	}
+
+	// Conversion is bandwidth bound; only split large buffers.
+	constexpr size_t kMinTaskElements = 65536;
+	parallelFor(0, count, num_threads, kMinTaskElements, [&](size_t begin, size_t end) {
+		convertRange(src, src_type, dst, dst_type, begin, end);
+	});
+	return true;
+}
+}        // namespace gomang
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "memory.h"
+
+namespace gomang
+{
+// Storage/compute precision a backend is asked to run in. Backends without a
+// matching mode fall back to kFP32.
+enum class Precision
+{
+	kFP32,
+	kFP16,
+	kBF16
+};
+
+inline const char *getPrecisionName(const Precision precision)
+{
+	switch (precision)
+	{
+		case Precision::kFP32:
+			return "FP32";
+		case Precision::kFP16:
+			return "FP16";
+		case Precision::kBF16:
+			return "BF16";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+// Scalar conversions, round to nearest even. NaN stays NaN.
+uint16_t floatToHalf(float value);
+float    halfToFloat(uint16_t value);
+uint16_t floatToBfloat16(float value);
+float    bfloat16ToFloat(uint16_t value);
+
+// Single-threaded, untraced array forms for use inside other kernels.
+void halfToFloatArray(const uint16_t *src, float *dst, size_t count);
+void floatToHalfArray(const float *src, uint16_t *dst, size_t count);
+void bfloat16ToFloatArray(const uint16_t *src, float *dst, size_t count);
+void floatToBfloat16Array(const float *src, uint16_t *dst, size_t count);
+
+// Converts count elements between kFLOAT32, kFLOAT16 and kBFLOAT16; equal
+// types are copied. Uses F16C, AVX-512 and AVX-512 BF16 when the CPU has them
+// (the BF16 instructions flush subnormal inputs to zero). src and dst must
+// not overlap.
+bool convertDataType(const void *src, DataType src_type,
+                     void *dst, DataType dst_type,
+                     size_t count, unsigned int num_threads = 1);
+}        // namespace gomang
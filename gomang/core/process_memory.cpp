@@ -0,0 +1,35 @@
+#include "process_memory.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace gomang
+{
+ProcessMemory readProcessMemory()
+{
+	ProcessMemory memory;
+
+	FILE *file = std::fopen("/proc/self/status", "r");
+	if (!file)
+	{
+		return memory;
+	}
+
+	// Lines look like "VmRSS:\t  123456 kB".
+	char line[256];
+	while (std::fgets(line, sizeof(line), file))
+	{
+		unsigned long kb = 0;
+		if (std::strncmp(line, "VmRSS:", 6) == 0 && std::sscanf(line + 6, "%lu", &kb) == 1)
+		{
+			memory.rss_bytes = static_cast<size_t>(kb) * 1024;
+		}
+		else if (std::strncmp(line, "VmHWM:", 6) == 0 && std::sscanf(line + 6, "%lu", &kb) == 1)
+		{
+			memory.peak_rss_bytes = static_cast<size_t>(kb) * 1024;
+		}
+	}
+	std::fclose(file);
+	return memory;
+}
+}        // namespace gomang
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace gomang
+{
+// Resident set of the current process, from VmRSS/VmHWM in /proc/self/status.
+// Both are 0 where that file is not available.
+struct ProcessMemory
+{
+	size_t rss_bytes{0};
+	size_t peak_rss_bytes{0};        // high-water mark since process start
+};
+
+ProcessMemory readProcessMemory();
+}        // namespace gomang
@@ -1,5 +1,6 @@
 #include "tensor.h"
 
+#include <cstdlib>
 #include <iostream>
 #include <numeric>
 #include <utility>
@@ -30,12 +31,13 @@ size_t TensorDesc::getElementsCount() const
 	return std::reduce(shape.begin(), shape.end(),
 	                   1ULL, std::multiplies<>());
 }
+size_t TensorDesc::getByteSize() const
+{
+	return getElementsCount() * getDataTypeSize(data_type);
+}
 size_t TensorDesc::calculateSize() const
 {
-	size_t element_size = getDataTypeSize(data_type);
-	size_t num_elements = getElementsCount();
-
-	size_t total_size = num_elements * element_size;
+	size_t total_size = getByteSize();
 	return (total_size + alignment - 1) & ~(alignment - 1);
 }
 void TensorDesc::print() const
@@ -61,10 +63,19 @@ Tensor::Tensor(TensorDesc desc, IMemoryAllocator *allocator) :
 }
 Tensor::~Tensor()
 {
-	if (allocator_ && data_)
+	if (!data_)
+	{
+		return;
+	}
+
+	if (allocator_)
 	{
 		allocator_->deallocate(data_, desc_.mem_type);
 	}
+	else
+	{
+		std::free(data_);
+	}
 }
 const void *Tensor::data() const
 {
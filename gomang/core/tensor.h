@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -17,7 +18,8 @@ struct TensorDesc
 	std::string          name;
 
 	[[nodiscard]] size_t getElementsCount() const;
-	[[nodiscard]] size_t calculateSize() const;
+	[[nodiscard]] size_t getByteSize() const;          // elements * element size
+	[[nodiscard]] size_t calculateSize() const;        // getByteSize() rounded up to alignment
 	void print() const;
 };
 
@@ -38,6 +40,9 @@ class Tensor : public ITensor
 
 	~Tensor() override;
 
+	Tensor(const Tensor &)            = delete;
+	Tensor &operator=(const Tensor &) = delete;
+
 	[[nodiscard]] const void       *data() const override;
 	void                           *data() override;
 	[[nodiscard]] const TensorDesc &desc() const override;
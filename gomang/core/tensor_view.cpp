@@ -0,0 +1,242 @@
+#include "tensor_view.h"
+
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace gomang
+{
+namespace
+{
+int64_t getCount(const std::vector<int64_t> &shape)
+{
+	return std::reduce(shape.begin(), shape.end(), int64_t{1}, std::multiplies<>());
+}
+
+// Copies a strided view into dense dst, one memcpy per run of trailing
+// dimensions that are already contiguous.
+void copyStrided(const uint8_t *src, uint8_t *dst, const std::vector<int64_t> &shape,
+                 const std::vector<int64_t> &strides, size_t elem_size)
+{
+	size_t  inner = shape.size();
+	int64_t run   = 1;
+	while (inner > 0 && (shape[inner - 1] == 1 || strides[inner - 1] == run))
+	{
+		run *= shape[inner - 1];
+		--inner;
+	}
+
+	const size_t         run_bytes = static_cast<size_t>(run) * elem_size;
+	const int64_t        outer     = std::reduce(shape.begin(), shape.begin() + inner, int64_t{1}, std::multiplies<>());
+	std::vector<int64_t> index(inner, 0);
+	for (int64_t i = 0; i < outer; ++i)
+	{
+		int64_t offset = 0;
+		for (size_t d = 0; d < inner; ++d)
+		{
+			offset += index[d] * strides[d];
+		}
+		std::memcpy(dst, src + offset * static_cast<int64_t>(elem_size), run_bytes);
+		dst += run_bytes;
+
+		for (size_t d = inner; d-- > 0;)
+		{
+			if (++index[d] < shape[d])
+			{
+				break;
+			}
+			index[d] = 0;
+		}
+	}
+}
+}        // namespace
+
+TensorView::TensorView(std::shared_ptr<ITensor> tensor) :
+    data_(static_cast<uint8_t *>(tensor->data())),
+    desc_(tensor->desc())
+{
+	storage_ = std::move(tensor);
+	setDenseStrides();
+}
+
+TensorView::TensorView(const TensorDesc &desc, void *data) :
+    data_(static_cast<uint8_t *>(data)),
+    desc_(desc)
+{
+	setDenseStrides();
+}
+
+TensorView TensorView::allocate(const TensorDesc &desc, IMemoryAllocator *allocator)
+{
+	return TensorView(std::make_shared<Tensor>(desc, allocator));
+}
+
+TensorView TensorView::slice(size_t dim, int64_t begin, int64_t end) const
+{
+	if (dim >= desc_.shape.size() || begin < 0 || begin > end || end > desc_.shape[dim])
+	{
+		throw std::out_of_range("TensorView::slice: range out of bounds");
+	}
+	if (desc_.layout == MemoryLayout::kNC4HW4 && dim != 0)
+	{
+		throw std::out_of_range("TensorView::slice: NC4HW4 views only slice the batch dimension");
+	}
+
+	TensorView view = *this;
+	view.data_ += begin * strides_[dim] * static_cast<int64_t>(getDataTypeSize(desc_.data_type));
+	view.desc_.shape[dim] = end - begin;
+	view.updateAlignment();
+	return view;
+}
+
+TensorView TensorView::sliceBatch(int64_t begin, int64_t end) const
+{
+	return slice(0, begin, end);
+}
+
+TensorView TensorView::sliceChannels(int64_t begin, int64_t end) const
+{
+	return slice(desc_.layout == MemoryLayout::kNHWC ? 3 : 1, begin, end);
+}
+
+TensorView TensorView::crop(int64_t y, int64_t x, int64_t height, int64_t width) const
+{
+	const size_t h_dim = desc_.layout == MemoryLayout::kNHWC ? 1 : 2;
+	return slice(h_dim, y, y + height).slice(h_dim + 1, x, x + width);
+}
+
+TensorView TensorView::reshape(std::vector<int64_t> shape) const
+{
+	return reshape(std::move(shape), desc_.layout);
+}
+
+TensorView TensorView::reshape(std::vector<int64_t> shape, MemoryLayout layout) const
+{
+	if (desc_.layout == MemoryLayout::kNC4HW4 || layout == MemoryLayout::kNC4HW4)
+	{
+		throw std::invalid_argument("TensorView::reshape: NC4HW4 views cannot be reshaped");
+	}
+	if (!isContiguous())
+	{
+		throw std::invalid_argument("TensorView::reshape: view is not contiguous");
+	}
+	if (getCount(shape) != getCount(desc_.shape))
+	{
+		throw std::invalid_argument("TensorView::reshape: element count mismatch");
+	}
+
+	TensorView view   = *this;
+	view.desc_.shape  = std::move(shape);
+	view.desc_.layout = layout;
+	view.setDenseStrides();
+	return view;
+}
+
+bool TensorView::isContiguous() const
+{
+	if (desc_.layout == MemoryLayout::kNC4HW4)
+	{
+		return true;
+	}
+
+	int64_t expected = 1;
+	for (size_t d = desc_.shape.size(); d-- > 0;)
+	{
+		if (desc_.shape[d] != 1 && strides_[d] != expected)
+		{
+			return false;
+		}
+		expected *= desc_.shape[d];
+	}
+	return true;
+}
+
+TensorView TensorView::contiguous() const
+{
+	if (isContiguous())
+	{
+		return *this;
+	}
+
+	TensorDesc dense_desc = desc_;
+	dense_desc.alignment  = 64;
+	TensorView dense      = allocate(dense_desc);
+	copyStrided(data_, dense.data_, desc_.shape, strides_, getDataTypeSize(desc_.data_type));
+	return dense;
+}
+
+const std::vector<int64_t> &TensorView::getStrides() const
+{
+	return strides_;
+}
+
+void *TensorView::data()
+{
+	return data_;
+}
+
+const void *TensorView::data() const
+{
+	return data_;
+}
+
+const TensorDesc &TensorView::desc() const
+{
+	return desc_;
+}
+
+size_t TensorView::size() const
+{
+	const size_t elem_size = getDataTypeSize(desc_.data_type);
+	if (desc_.shape.empty() || getCount(desc_.shape) == 0)
+	{
+		return 0;
+	}
+	if (desc_.layout == MemoryLayout::kNC4HW4)
+	{
+		return static_cast<size_t>(desc_.shape[0] * strides_[0]) * elem_size;
+	}
+
+	int64_t last = 0;
+	for (size_t d = 0; d < desc_.shape.size(); ++d)
+	{
+		last += (desc_.shape[d] - 1) * strides_[d];
+	}
+	return static_cast<size_t>(last + 1) * elem_size;
+}
+
+void TensorView::setDenseStrides()
+{
+	const auto &shape = desc_.shape;
+	strides_.assign(shape.size(), 0);
+	if (shape.empty())
+	{
+		return;
+	}
+
+	// Packed channels have no per-dimension stride; only the batch step exists.
+	if (desc_.layout == MemoryLayout::kNC4HW4)
+	{
+		strides_[0] = shape[0] > 0 ? static_cast<int64_t>(desc_.getElementsCount()) / shape[0] : 0;
+		return;
+	}
+
+	int64_t stride = 1;
+	for (size_t d = shape.size(); d-- > 0;)
+	{
+		strides_[d] = stride;
+		stride *= shape[d];
+	}
+}
+
+void TensorView::updateAlignment()
+{
+	// Offset views only keep the alignment their address actually has.
+	const auto address = reinterpret_cast<uintptr_t>(data_);
+	while (desc_.alignment > 1 && address % desc_.alignment != 0)
+	{
+		desc_.alignment /= 2;
+	}
+}
+}        // namespace gomang
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensor.h"
+
+namespace gomang
+{
+// A window onto tensor storage: shape from desc(), per-dimension strides in
+// elements, and a shared reference to the storage so sub-views keep it alive.
+// Slicing and reshaping never copy. Engines and other ITensor consumers read
+// data() as a dense buffer, so only hand them views where isContiguous() holds
+// (batch slices always do) or pass contiguous() instead.
+//
+// kNC4HW4 views can only be sliced along the batch dimension.
+class TensorView : public ITensor
+{
+  public:
+	TensorView() = default;
+
+	// Shares ownership of tensor.
+	explicit TensorView(std::shared_ptr<ITensor> tensor);
+
+	// Non-owning view over dense caller memory, which must outlive it.
+	TensorView(const TensorDesc &desc, void *data);
+
+	static TensorView allocate(const TensorDesc &desc, IMemoryAllocator *allocator = nullptr);
+
+	// Elements [begin, end) of dimension dim; throws std::out_of_range.
+	[[nodiscard]] TensorView slice(size_t dim, int64_t begin, int64_t end) const;
+	[[nodiscard]] TensorView sliceBatch(int64_t begin, int64_t end) const;
+	[[nodiscard]] TensorView sliceChannels(int64_t begin, int64_t end) const;        // C by layout
+	[[nodiscard]] TensorView crop(int64_t y, int64_t x, int64_t height, int64_t width) const;
+
+	// Same elements under a new shape; throws std::invalid_argument unless the
+	// view is contiguous and the element count matches.
+	[[nodiscard]] TensorView reshape(std::vector<int64_t> shape) const;
+	[[nodiscard]] TensorView reshape(std::vector<int64_t> shape, MemoryLayout layout) const;
+
+	[[nodiscard]] bool isContiguous() const;
+
+	// This view if contiguous, otherwise a dense copy in new storage.
+	[[nodiscard]] TensorView contiguous() const;
+
+	[[nodiscard]] const std::vector<int64_t> &getStrides() const;
+
+	void                           *data() override;
+	[[nodiscard]] const void       *data() const override;
+	[[nodiscard]] const TensorDesc &desc() const override;
+
+	// Bytes from the first to one past the last element, without alignment
+	// padding; for a contiguous view, the exact dense size.
+	[[nodiscard]] size_t size() const override;
+
+  private:
+	std::shared_ptr<void> storage_;
+	uint8_t              *data_{nullptr};
+	TensorDesc            desc_{};
+	std::vector<int64_t>  strides_;
+
+	void setDenseStrides();
+	void updateAlignment();
+};
+}        // namespace gomang
@@ -0,0 +1,207 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace gomang
+{
+namespace
+{
+constexpr size_t kChunkEvents = 1 << 10;        // ring storage grows in chunks of this many events
+static_assert(Tracer::kRingCapacity % kChunkEvents == 0);
+
+// Ring of events, shared in turn by threads: when a thread exits its buffer
+// goes on the free list and the next new thread records into it. Events keep
+// their own thread_id, so earlier events survive for export, and memory is
+// bounded by the peak number of live tracing threads, not by thread churn.
+struct ThreadBuffer
+{
+	std::mutex                                 mutex;        // only contended while collecting
+	std::vector<std::unique_ptr<TraceEvent[]>> chunks;       // allocated on first use
+	size_t                                     next{0};
+	bool                                       wrapped{false};
+
+	TraceEvent &at(size_t index)
+	{
+		return chunks[index / kChunkEvents][index % kChunkEvents];
+	}
+};
+
+struct Registry
+{
+	std::mutex                                 mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	std::vector<std::shared_ptr<ThreadBuffer>> free_buffers;
+	uint32_t                                   next_thread_id{1};
+};
+
+// Never destroyed: worker threads may still exit during static destruction.
+Registry &registry()
+{
+	static auto *instance = new Registry;
+	return *instance;
+}
+
+struct ThreadSlot
+{
+	std::shared_ptr<ThreadBuffer> buffer;
+	uint32_t                      thread_id{0};
+
+	ThreadSlot()
+	{
+		auto                       &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		thread_id = reg.next_thread_id++;
+		if (!reg.free_buffers.empty())
+		{
+			buffer = std::move(reg.free_buffers.back());
+			reg.free_buffers.pop_back();
+		}
+		else
+		{
+			buffer = std::make_shared<ThreadBuffer>();
+			reg.buffers.push_back(buffer);
+		}
+	}
+
+	~ThreadSlot()
+	{
+		auto                       &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		reg.free_buffers.push_back(std::move(buffer));
+	}
+
+	ThreadSlot(const ThreadSlot &)            = delete;
+	ThreadSlot &operator=(const ThreadSlot &) = delete;
+};
+
+ThreadSlot &threadSlot()
+{
+	thread_local ThreadSlot slot;
+	return slot;
+}
+
+void writeJsonString(std::ostream &os, const char *str)
+{
+	os << '"';
+	for (; *str; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+		{
+			os << '\\';
+		}
+		os << *str;
+	}
+	os << '"';
+}
+}        // namespace
+
+std::atomic<bool> Tracer::enabled_{false};
+
+void Tracer::setEnabled(bool enabled)
+{
+	enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t Tracer::nowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+void Tracer::record(const char *category, const char *name, uint64_t start_ns, uint64_t end_ns)
+{
+	auto &slot   = threadSlot();
+	auto &buffer = *slot.buffer;
+
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	if (buffer.next / kChunkEvents == buffer.chunks.size())
+	{
+		buffer.chunks.push_back(std::make_unique<TraceEvent[]>(kChunkEvents));
+	}
+	buffer.at(buffer.next) = {category, name, start_ns, end_ns - start_ns, slot.thread_id};
+	if (++buffer.next == Tracer::kRingCapacity)
+	{
+		buffer.next    = 0;
+		buffer.wrapped = true;
+	}
+}
+
+std::vector<TraceEvent> Tracer::collect()
+{
+	auto &reg = registry();
+
+	std::vector<TraceEvent>     events;
+	std::lock_guard<std::mutex> reg_lock(reg.mutex);
+	for (const auto &buffer : reg.buffers)
+	{
+		std::lock_guard<std::mutex> lock(buffer->mutex);
+		if (buffer->wrapped)
+		{
+			for (size_t i = buffer->next; i < Tracer::kRingCapacity; ++i)
+			{
+				events.push_back(buffer->at(i));
+			}
+		}
+		for (size_t i = 0; i < buffer->next; ++i)
+		{
+			events.push_back(buffer->at(i));
+		}
+	}
+	return events;
+}
+
+void Tracer::clear()
+{
+	auto &reg = registry();
+
+	std::lock_guard<std::mutex> reg_lock(reg.mutex);
+	for (const auto &buffer : reg.buffers)
+	{
+		std::lock_guard<std::mutex> lock(buffer->mutex);
+		buffer->chunks.clear();
+		buffer->next    = 0;
+		buffer->wrapped = false;
+	}
+}
+
+bool Tracer::exportChromeTrace(const std::string &path)
+{
+	auto events = collect();
+	std::sort(events.begin(), events.end(),
+	          [](const TraceEvent &a, const TraceEvent &b) { return a.start_ns < b.start_ns; });
+
+	std::ofstream file(path);
+	if (!file.good())
+	{
+		std::cerr << "Failed to open trace file: " << path << std::endl;
+		return false;
+	}
+
+	const uint64_t origin = events.empty() ? 0 : events.front().start_ns;
+
+	// Timestamps are microseconds with nanosecond fractions, as the format expects.
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const auto &event = events[i];
+		file << (i ? ",\n" : "\n") << "{\"name\":";
+		writeJsonString(file, event.name);
+		file << ",\"cat\":";
+		writeJsonString(file, event.category);
+		file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_id
+		     << ",\"ts\":" << static_cast<double>(event.start_ns - origin) / 1000.0
+		     << ",\"dur\":" << static_cast<double>(event.duration_ns) / 1000.0 << "}";
+	}
+	file << "\n]}\n";
+
+	return file.good();
+}
+}        // namespace gomang
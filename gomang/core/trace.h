@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gomang
+{
+struct TraceEvent
+{
+	const char *category;        // string literals only; pointers are stored as is
+	const char *name;
+	uint64_t    start_ns;
+	uint64_t    duration_ns;
+	uint32_t    thread_id;
+};
+
+// Collects phase timings into per-thread ring buffers and exports them as
+// Chrome trace-event JSON (chrome://tracing, Perfetto). Disabled by default;
+// a disabled TraceScope costs one relaxed atomic load. Buffers grow as events
+// arrive, are handed to new threads once their thread exits, and clear()
+// releases their storage.
+class Tracer
+{
+  public:
+	static constexpr size_t kRingCapacity = 1 << 16;        // events kept per buffer
+
+	static void setEnabled(bool enabled);
+
+	static bool isEnabled()
+	{
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	static uint64_t nowNs();
+
+	static void record(const char *category, const char *name, uint64_t start_ns, uint64_t end_ns);
+
+	// Events from every thread, oldest first per thread.
+	static std::vector<TraceEvent> collect();
+
+	static void clear();
+
+	static bool exportChromeTrace(const std::string &path);
+
+  private:
+	static std::atomic<bool> enabled_;
+};
+
+class TraceScope
+{
+  public:
+	TraceScope(const char *category, const char *name) :
+	    category_(category), name_(name), active_(Tracer::isEnabled())
+	{
+		if (active_)
+		{
+			start_ns_ = Tracer::nowNs();
+		}
+	}
+
+	~TraceScope()
+	{
+		if (active_)
+		{
+			Tracer::record(category_, name_, start_ns_, Tracer::nowNs());
+		}
+	}
+
+	TraceScope(const TraceScope &)            = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+
+  private:
+	const char *category_;
+	const char *name_;
+	uint64_t    start_ns_{0};
+	bool        active_;
+};
+}        // namespace gomang
+
+#define GOMANG_TRACE_CONCAT_IMPL(a, b) a##b
+#define GOMANG_TRACE_CONCAT(a, b) GOMANG_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef GOMANG_DISABLE_TRACE
+#	define GOMANG_TRACE_SCOPE(category, name)
+#else
+#	define GOMANG_TRACE_SCOPE(category, name) \
+		::gomang::TraceScope GOMANG_TRACE_CONCAT(gomang_trace_scope_, __LINE__)(category, name)
+#endif
@@ -0,0 +1,206 @@
+#include "tracking_allocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace gomang
+{
+namespace
+{
+constexpr size_t kFirstSizeClassBits = 10;        // class 0 holds up to 1 KiB
+
+void printBytes(size_t bytes)
+{
+	constexpr double kKiB = 1024.0;
+	if (bytes < 1024)
+	{
+		std::cout << bytes << " B";
+	}
+	else if (bytes < (1ull << 20))
+	{
+		std::cout << bytes / kKiB << " KiB";
+	}
+	else
+	{
+		std::cout << bytes / (kKiB * kKiB) << " MiB";
+	}
+}
+}        // namespace
+
+size_t MemoryStats::getSizeClass(size_t size)
+{
+	if (size <= (1ull << kFirstSizeClassBits))
+	{
+		return 0;
+	}
+	return std::min<size_t>(std::bit_width(size - 1) - kFirstSizeClassBits, kNumSizeClasses - 1);
+}
+
+size_t MemoryStats::getSizeClassBound(size_t size_class)
+{
+	return size_class + 1 < kNumSizeClasses ? 1ull << (kFirstSizeClassBits + size_class) : 0;
+}
+
+const MemoryStats &AllocatorStats::get(MemoryType type) const
+{
+	return per_type[static_cast<size_t>(type)];
+}
+
+void AllocatorStats::merge(const AllocatorStats &other)
+{
+	for (size_t i = 0; i < kNumMemoryTypes; ++i)
+	{
+		auto       &stats = per_type[i];
+		const auto &add   = other.per_type[i];
+		stats.live_bytes += add.live_bytes;
+		stats.peak_bytes += add.peak_bytes;
+		stats.live_count += add.live_count;
+		stats.num_allocations += add.num_allocations;
+		stats.num_failures += add.num_failures;
+		for (size_t c = 0; c < MemoryStats::kNumSizeClasses; ++c)
+		{
+			stats.size_histogram[c] += add.size_histogram[c];
+		}
+	}
+}
+
+void AllocatorStats::print() const
+{
+	auto flags     = std::cout.flags();
+	auto precision = std::cout.precision();
+
+	std::cout << "=== Allocator Memory ===" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (size_t i = 0; i < kNumMemoryTypes; ++i)
+	{
+		const auto &stats = per_type[i];
+		if (stats.num_allocations == 0 && stats.num_failures == 0)
+		{
+			continue;
+		}
+
+		std::cout << getMemoryTypeName(static_cast<MemoryType>(i)) << ": live ";
+		printBytes(stats.live_bytes);
+		std::cout << " in " << stats.live_count << " blocks | peak ";
+		printBytes(stats.peak_bytes);
+		std::cout << " | " << stats.num_allocations << " allocations, " << stats.num_failures << " failed"
+		          << std::endl;
+
+		for (size_t c = 0; c < MemoryStats::kNumSizeClasses; ++c)
+		{
+			if (stats.size_histogram[c] == 0)
+			{
+				continue;
+			}
+			std::cout << "  ";
+			if (const size_t bound = MemoryStats::getSizeClassBound(c); bound > 0)
+			{
+				std::cout << "<= ";
+				printBytes(bound);
+			}
+			else
+			{
+				std::cout << "> ";
+				printBytes(MemoryStats::getSizeClassBound(c - 1));
+			}
+			std::cout << ": " << stats.size_histogram[c] << std::endl;
+		}
+	}
+	std::cout << "========================" << std::endl;
+
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+}
+
+TrackingAllocator::TrackingAllocator(IMemoryAllocator *upstream, size_t alignment) :
+    upstream_(upstream),
+    alignment_(std::bit_ceil(alignment))
+{
+}
+
+void *TrackingAllocator::allocate(size_t size, MemoryType type)
+{
+	void *ptr = nullptr;
+	if (upstream_)
+	{
+		ptr = upstream_->allocate(size, type);
+	}
+	else if (type == MemoryType::kGPU)
+	{
+		std::cerr << "TrackingAllocator: GPU memory requires an upstream allocator" << std::endl;
+	}
+	else
+	{
+		ptr = std::aligned_alloc(alignment_, (size + alignment_ - 1) & ~(alignment_ - 1));
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto                       &stats = stats_.per_type[static_cast<size_t>(type)];
+	if (!ptr)
+	{
+		++stats.num_failures;
+		return nullptr;
+	}
+
+	stats.live_bytes += size;
+	stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+	++stats.live_count;
+	++stats.num_allocations;
+	++stats.size_histogram[MemoryStats::getSizeClass(size)];
+	live_blocks_.emplace(ptr, Block{size, type});
+	return ptr;
+}
+
+void TrackingAllocator::deallocate(void *ptr, MemoryType type)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto                        it = live_blocks_.find(ptr);
+		if (it == live_blocks_.end())
+		{
+			std::cerr << "TrackingAllocator: deallocating unknown pointer" << std::endl;
+			return;
+		}
+
+		// Charged to the type it was allocated as, whatever the caller passes.
+		const Block block = it->second;
+		auto       &stats = stats_.per_type[static_cast<size_t>(block.type)];
+		stats.live_bytes -= block.size;
+		--stats.live_count;
+		live_blocks_.erase(it);
+		type = block.type;
+	}
+
+	if (upstream_)
+	{
+		upstream_->deallocate(ptr, type);
+	}
+	else
+	{
+		std::free(ptr);
+	}
+}
+
+AllocatorStats TrackingAllocator::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
+
+void TrackingAllocator::resetPeak()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto &stats : stats_.per_type)
+	{
+		stats.peak_bytes = stats.live_bytes;
+	}
+}
+}        // namespace gomang
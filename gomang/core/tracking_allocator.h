@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+#include "memory.h"
+
+namespace gomang
+{
+// Accounting for one MemoryType. Byte counts are the sizes requested from
+// the allocator, not what the upstream actually reserves.
+struct MemoryStats
+{
+	// Allocations by requested size: class 0 is up to 1 KiB, each following
+	// class doubles the bound, and the last one takes everything larger.
+	static constexpr size_t kNumSizeClasses = 20;
+
+	size_t live_bytes{0};
+	size_t peak_bytes{0};
+	size_t live_count{0};
+	size_t num_allocations{0};
+	size_t num_failures{0};
+
+	std::array<size_t, kNumSizeClasses> size_histogram{};
+
+	static size_t getSizeClass(size_t size);
+	static size_t getSizeClassBound(size_t size_class);        // upper bound in bytes; 0 for the last class
+};
+
+struct AllocatorStats
+{
+	static constexpr size_t kNumMemoryTypes = 3;
+
+	std::array<MemoryStats, kNumMemoryTypes> per_type{};
+
+	[[nodiscard]] const MemoryStats &get(MemoryType type) const;
+
+	// Adds other's counts; peaks are summed, so they bound the combined peak.
+	void merge(const AllocatorStats &other);
+
+	// One line per memory type that saw allocations, plus its histogram.
+	void print() const;
+};
+
+// Decorator that counts everything passing through to upstream: live and
+// peak bytes, allocation counts and a size histogram per MemoryType. Wrap the
+// allocator given to EngineOptions::host_allocator (or a backend's own) with
+// it; Benchmark reports print the stats of a tracked engine.
+class TrackingAllocator : public IMemoryAllocator
+{
+  public:
+	// upstream == nullptr falls back to std::aligned_alloc for host memory types.
+	explicit TrackingAllocator(IMemoryAllocator *upstream = nullptr, size_t alignment = 64);
+
+	TrackingAllocator(const TrackingAllocator &)            = delete;
+	TrackingAllocator &operator=(const TrackingAllocator &) = delete;
+
+	void *allocate(size_t size, MemoryType type) override;
+	void  deallocate(void *ptr, MemoryType type) override;
+
+	[[nodiscard]] AllocatorStats getStats() const;
+
+	// Restarts the peaks at the current live bytes, e.g. after model load.
+	void resetPeak();
+
+  private:
+	struct Block
+	{
+		size_t     size;        // as requested
+		MemoryType type;
+	};
+
+	IMemoryAllocator *upstream_;
+	size_t            alignment_;
+
+	mutable std::mutex                mutex_;
+	AllocatorStats                    stats_;
+	std::unordered_map<void *, Block> live_blocks_;
+};
+}        // namespace gomang
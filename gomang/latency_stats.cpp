@@ -0,0 +1,129 @@
+#include "latency_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+
+namespace gomang
+{
+namespace
+{
+// Nearest-rank percentile on sorted samples.
+double percentile(const std::vector<double> &sorted, double p)
+{
+	if (sorted.empty())
+	{
+		return 0.0;
+	}
+	auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+}        // namespace
+
+LatencyStats LatencyStats::compute(std::vector<double> samples_ms, size_t num_bins)
+{
+	LatencyStats stats;
+	stats.count = samples_ms.size();
+	if (samples_ms.empty())
+	{
+		return stats;
+	}
+
+	std::sort(samples_ms.begin(), samples_ms.end());
+
+	const auto n    = static_cast<double>(samples_ms.size());
+	stats.mean_ms   = std::accumulate(samples_ms.begin(), samples_ms.end(), 0.0) / n;
+	double variance = 0.0;
+	for (double sample : samples_ms)
+	{
+		variance += (sample - stats.mean_ms) * (sample - stats.mean_ms);
+	}
+	stats.stddev_ms          = samples_ms.size() > 1 ? std::sqrt(variance / (n - 1)) : 0.0;
+	stats.ci95_half_width_ms = 1.96 * stats.stddev_ms / std::sqrt(n);
+
+	stats.min_ms  = samples_ms.front();
+	stats.max_ms  = samples_ms.back();
+	stats.p50_ms  = percentile(samples_ms, 50.0);
+	stats.p90_ms  = percentile(samples_ms, 90.0);
+	stats.p99_ms  = percentile(samples_ms, 99.0);
+	stats.p999_ms = percentile(samples_ms, 99.9);
+
+	// Log-spaced bins keep the body of the distribution readable next to a long tail.
+	num_bins          = std::max<size_t>(num_bins, 1);
+	const bool   log  = stats.min_ms > 0.0;
+	const double low  = log ? std::log(stats.min_ms) : stats.min_ms;
+	const double high = log ? std::log(stats.max_ms) : stats.max_ms;
+	const double bin  = (high - low) / static_cast<double>(num_bins);
+	stats.histogram.resize(num_bins);
+	for (size_t i = 0; i < num_bins; ++i)
+	{
+		double edge        = low + bin * static_cast<double>(i + 1);
+		stats.histogram[i] = {log ? std::exp(edge) : edge, 0};
+	}
+	stats.histogram.back().upper_ms = stats.max_ms;
+	for (double sample : samples_ms)
+	{
+		double value = log ? std::log(sample) : sample;
+		auto   index = bin > 0.0 ? static_cast<size_t>((value - low) / bin) : 0;
+		stats.histogram[std::min(index, num_bins - 1)].count++;
+	}
+
+	return stats;
+}
+
+double LatencyStats::getThroughput() const
+{
+	return mean_ms > 0.0 ? 1000.0 / mean_ms : 0.0;
+}
+
+void LatencyStats::print() const
+{
+	auto flags     = std::cout.flags();
+	auto precision = std::cout.precision();
+
+	std::cout << std::fixed << std::setprecision(3)
+	          << "Latency over " << count << " runs (ms): "
+	          << "mean " << mean_ms << " +/- " << ci95_half_width_ms
+	          << " | stddev " << stddev_ms << std::endl
+	          << "  min " << min_ms
+	          << " | p50 " << p50_ms
+	          << " | p90 " << p90_ms
+	          << " | p99 " << p99_ms
+	          << " | p99.9 " << p999_ms
+	          << " | max " << max_ms << std::endl;
+
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+}
+
+void LatencyStats::printHistogram() const
+{
+	size_t peak = 0;
+	for (const auto &bin : histogram)
+	{
+		peak = std::max(peak, bin.count);
+	}
+	if (peak == 0)
+	{
+		return;
+	}
+
+	auto flags     = std::cout.flags();
+	auto precision = std::cout.precision();
+
+	constexpr size_t kBarWidth = 40;
+	std::cout << std::fixed << std::setprecision(3);
+	for (const auto &bin : histogram)
+	{
+		std::cout << "  <= " << std::setw(10) << bin.upper_ms << " ms | "
+		          << std::string(bin.count * kBarWidth / peak, '#')
+		          << " " << bin.count << std::endl;
+	}
+
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+}
+}        // namespace gomang
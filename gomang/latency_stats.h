@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace gomang
+{
+struct LatencyStats
+{
+	struct Bin
+	{
+		double upper_ms;
+		size_t count;
+	};
+
+	size_t count{0};
+	double mean_ms{0};
+	double stddev_ms{0};
+	double ci95_half_width_ms{0};        // half-width of the 95% confidence interval of the mean
+	double min_ms{0};
+	double p50_ms{0};
+	double p90_ms{0};
+	double p99_ms{0};
+	double p999_ms{0};
+	double max_ms{0};
+
+	std::vector<Bin> histogram;
+
+	static LatencyStats compute(std::vector<double> samples_ms, size_t num_bins = 20);
+
+	[[nodiscard]] double getThroughput() const;        // requests per second at the mean latency
+
+	void print() const;
+	void printHistogram() const;
+};
+}        // namespace gomang
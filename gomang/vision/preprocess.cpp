@@ -0,0 +1,430 @@
+#include "preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "core/layout.h"
+#include "core/parallel.h"
+#include "core/precision.h"
+#include "core/trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#	define GOMANG_PREPROCESS_X86 1
+#	include <immintrin.h>
+#endif
+
+namespace gomang
+{
+namespace
+{
+int getChannelCount(PixelFormat format)
+{
+	switch (format)
+	{
+		case PixelFormat::kGRAY:
+			return 1;
+		case PixelFormat::kRGBA:
+		case PixelFormat::kBGRA:
+			return 4;
+		default:
+			return 3;
+	}
+}
+
+// Position of R, G, B and A within a pixel; -1 if the format has no such channel.
+std::array<int, 4> getRgbaIndex(PixelFormat format)
+{
+	switch (format)
+	{
+		case PixelFormat::kRGB:
+			return {0, 1, 2, -1};
+		case PixelFormat::kBGR:
+			return {2, 1, 0, -1};
+		case PixelFormat::kRGBA:
+			return {0, 1, 2, 3};
+		case PixelFormat::kBGRA:
+			return {2, 1, 0, 3};
+		default:
+			return {0, 0, 0, -1};
+	}
+}
+
+// Which source channel feeds each output channel. A missing alpha reads as
+// opaque; a gray output from a colour source is a luma mix of R, G and B.
+struct ChannelMap
+{
+	int                channels{0};
+	std::array<int, 4> index{};
+	bool               luma{false};
+	std::array<int, 3> rgb{};
+};
+
+ChannelMap makeChannelMap(PixelFormat src_format, PixelFormat dst_format)
+{
+	ChannelMap map;
+	map.channels = getChannelCount(dst_format);
+
+	const auto src_rgba = getRgbaIndex(src_format);
+	if (dst_format == PixelFormat::kGRAY && src_format != PixelFormat::kGRAY)
+	{
+		map.luma = true;
+		map.rgb  = {src_rgba[0], src_rgba[1], src_rgba[2]};
+		return map;
+	}
+
+	const auto dst_rgba = getRgbaIndex(dst_format);
+	for (int c = 0; c < map.channels; ++c)
+	{
+		// Invert dst_rgba: find which of R, G, B, A output channel c holds.
+		int semantic = 0;
+		for (int s = 0; s < 4; ++s)
+		{
+			if (dst_rgba[s] == c)
+			{
+				semantic = s;
+				break;
+			}
+		}
+		map.index[c] = src_rgba[semantic];
+	}
+	return map;
+}
+
+// Source taps for one axis: half-pixel centres, clamped at the borders.
+struct AxisTable
+{
+	std::vector<int>   i0;
+	std::vector<int>   i1;
+	std::vector<float> weight;
+};
+
+void computeTap(int i, float inv_scale, int src_size, int &i0, int &i1, float &weight)
+{
+	float f = (static_cast<float>(i) + 0.5f) * inv_scale - 0.5f;
+	f       = std::clamp(f, 0.0f, static_cast<float>(src_size - 1));
+	i0      = static_cast<int>(f);
+	i1      = std::min(i0 + 1, src_size - 1);
+	weight  = f - static_cast<float>(i0);
+}
+
+AxisTable makeAxisTable(int dst_size, int src_size, int pixel_bytes)
+{
+	AxisTable  table;
+	const auto inv_scale = static_cast<float>(src_size) / static_cast<float>(dst_size);
+	table.i0.resize(dst_size);
+	table.i1.resize(dst_size);
+	table.weight.resize(dst_size);
+	for (int i = 0; i < dst_size; ++i)
+	{
+		computeTap(i, inv_scale, src_size, table.i0[i], table.i1[i], table.weight[i]);
+		table.i0[i] *= pixel_bytes;
+		table.i1[i] *= pixel_bytes;
+	}
+	return table;
+}
+
+// Horizontal pass: one source row into per-channel float rows.
+void resampleRow(const uint8_t *row, const AxisTable &table, const ChannelMap &map, float *const out[4])
+{
+	const size_t count = table.weight.size();
+	if (map.luma)
+	{
+		const int r = map.rgb[0];
+		const int g = map.rgb[1];
+		const int b = map.rgb[2];
+		for (size_t x = 0; x < count; ++x)
+		{
+			const uint8_t *p0 = row + table.i0[x];
+			const uint8_t *p1 = row + table.i1[x];
+			const float    w  = table.weight[x];
+			const float    l0 = 0.299f * p0[r] + 0.587f * p0[g] + 0.114f * p0[b];
+			const float    l1 = 0.299f * p1[r] + 0.587f * p1[g] + 0.114f * p1[b];
+			out[0][x]         = l0 + w * (l1 - l0);
+		}
+		return;
+	}
+
+	for (int c = 0; c < map.channels; ++c)
+	{
+		const int idx = map.index[c];
+		float    *dst = out[c];
+		if (idx < 0)
+		{
+			std::fill(dst, dst + count, 255.0f);
+			continue;
+		}
+		for (size_t x = 0; x < count; ++x)
+		{
+			const float a = row[table.i0[x] + idx];
+			const float b = row[table.i1[x] + idx];
+			dst[x]        = a + table.weight[x] * (b - a);
+		}
+	}
+}
+
+// Vertical pass fused with normalization: dst = h0 * a + h1 * b + c.
+void blendRowsScalar(const float *h0, const float *h1, float a, float b, float c, float *dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		dst[i] = h0[i] * a + h1[i] * b + c;
+	}
+}
+
+#ifdef GOMANG_PREPROCESS_X86
+__attribute__((target("avx2,fma"))) void blendRowsAvx2(const float *h0, const float *h1, float a, float b, float c,
+                                                       float *dst, size_t count)
+{
+	const __m256 va = _mm256_set1_ps(a);
+	const __m256 vb = _mm256_set1_ps(b);
+	const __m256 vc = _mm256_set1_ps(c);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 r = _mm256_fmadd_ps(_mm256_loadu_ps(h1 + i), vb, vc);
+		r        = _mm256_fmadd_ps(_mm256_loadu_ps(h0 + i), va, r);
+		_mm256_storeu_ps(dst + i, r);
+	}
+	blendRowsScalar(h0 + i, h1 + i, a, b, c, dst + i, count - i);
+}
+#endif
+
+void blendRows(const float *h0, const float *h1, float a, float b, float c, float *dst, size_t count)
+{
+#ifdef GOMANG_PREPROCESS_X86
+	static const bool has_avx2 = [] {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	}();
+	if (has_avx2)
+	{
+		blendRowsAvx2(h0, h1, a, b, c, dst, count);
+		return;
+	}
+#endif
+	blendRowsScalar(h0, h1, a, b, c, dst, count);
+}
+
+void storeRow(const float *src, DataType type, void *dst, size_t count)
+{
+	switch (type)
+	{
+		case DataType::kFLOAT16:
+			floatToHalfArray(src, static_cast<uint16_t *>(dst), count);
+			break;
+		case DataType::kBFLOAT16:
+			floatToBfloat16Array(src, static_cast<uint16_t *>(dst), count);
+			break;
+		default:
+			std::memcpy(dst, src, count * sizeof(float));
+			break;
+	}
+}
+
+// Two cached horizontal rows, so consecutive output rows that share a source
+// row only resample it once.
+class RowCache
+{
+  public:
+	RowCache(size_t width, int channels)
+	{
+		for (auto &slot : slots_)
+		{
+			slot.storage.resize(width * channels);
+			for (int c = 0; c < channels; ++c)
+			{
+				slot.rows[c] = slot.storage.data() + c * width;
+			}
+		}
+	}
+
+	const float *const *get(int y, int keep, const ImageView &src, size_t stride, const AxisTable &table,
+	                        const ChannelMap &map)
+	{
+		for (auto &slot : slots_)
+		{
+			if (slot.y == y)
+			{
+				return slot.rows;
+			}
+		}
+
+		Slot &slot = slots_[0].y == keep ? slots_[1] : slots_[0];
+		resampleRow(src.data + static_cast<size_t>(y) * stride, table, map, slot.rows);
+		slot.y = y;
+		return slot.rows;
+	}
+
+  private:
+	struct Slot
+	{
+		int                y{-1};
+		std::vector<float> storage;
+		float             *rows[4]{};
+	};
+
+	Slot slots_[2];
+};
+}        // namespace
+
+bool preprocessImage(const ImageView &src, const TensorDesc &dst_desc, void *dst,
+                     const PreprocessOptions &options, ResizeInfo *info)
+{
+	GOMANG_TRACE_SCOPE("vision", "preprocess");
+
+	ImageDims dims;
+	if (!src.data || src.width <= 0 || src.height <= 0 || !dst || !getImageDims(dst_desc, dims))
+	{
+		std::cerr << "preprocessImage: invalid source image or destination tensor" << std::endl;
+		return false;
+	}
+	if (dims.c != getChannelCount(options.dst_format))
+	{
+		std::cerr << "preprocessImage: tensor has " << dims.c << " channels, format needs "
+		          << getChannelCount(options.dst_format) << std::endl;
+		return false;
+	}
+	if (dst_desc.data_type != DataType::kFLOAT32 && dst_desc.data_type != DataType::kFLOAT16 &&
+	    dst_desc.data_type != DataType::kBFLOAT16)
+	{
+		std::cerr << "preprocessImage: unsupported data type " << getDataTypeName(dst_desc.data_type) << std::endl;
+		return false;
+	}
+
+	const int    C           = static_cast<int>(dims.c);
+	const int    H           = static_cast<int>(dims.h);
+	const int    W           = static_cast<int>(dims.w);
+	const int    pixel_bytes = getChannelCount(src.format);
+	const size_t stride      = src.stride ? src.stride : static_cast<size_t>(src.width) * pixel_bytes;
+
+	ResizeInfo resize;
+	int        content_w = W;
+	int        content_h = H;
+	if (options.resize_mode == ResizeMode::kLetterbox)
+	{
+		const float scale = std::min(static_cast<float>(W) / src.width, static_cast<float>(H) / src.height);
+		content_w         = std::clamp(static_cast<int>(std::lround(src.width * scale)), 1, W);
+		content_h         = std::clamp(static_cast<int>(std::lround(src.height * scale)), 1, H);
+		resize.scale_x    = scale;
+		resize.scale_y    = scale;
+		resize.pad_x      = (W - content_w) / 2;
+		resize.pad_y      = (H - content_h) / 2;
+	}
+	else
+	{
+		resize.scale_x = static_cast<float>(W) / src.width;
+		resize.scale_y = static_cast<float>(H) / src.height;
+	}
+	if (info)
+	{
+		*info = resize;
+	}
+
+	const ChannelMap map    = makeChannelMap(src.format, options.dst_format);
+	const AxisTable  xtable = makeAxisTable(content_w, src.width, pixel_bytes);
+	const float      inv_sy = static_cast<float>(src.height) / static_cast<float>(content_h);
+
+	float pad_value[4];
+	for (int c = 0; c < C; ++c)
+	{
+		pad_value[c] = (options.pad_value - options.mean[c]) * options.norm[c];
+	}
+
+	const size_t HW           = static_cast<size_t>(H) * W;
+	const size_t element_size = getDataTypeSize(dst_desc.data_type);
+	const bool   direct       = dst_desc.layout == MemoryLayout::kNCHW && dst_desc.data_type == DataType::kFLOAT32;
+	auto        *out          = static_cast<uint8_t *>(dst);
+
+	const size_t grain = std::max<size_t>(1, 16384 / (static_cast<size_t>(W) * C));
+	parallelFor(0, H, options.num_threads, grain, [&](size_t begin, size_t end) {
+		RowCache           cache(content_w, map.channels);
+		std::vector<float> planes(direct ? 0 : static_cast<size_t>(W) * C);
+		std::vector<float> packed(direct ? 0 : static_cast<size_t>(W) * std::max(C, 4));
+
+		for (size_t y = begin; y < end; ++y)
+		{
+			float *rows[4];
+			for (int c = 0; c < C; ++c)
+			{
+				rows[c] = direct ? reinterpret_cast<float *>(out) + c * HW + y * W : planes.data() + c * W;
+			}
+
+			const int cy = static_cast<int>(y) - resize.pad_y;
+			if (cy < 0 || cy >= content_h)
+			{
+				for (int c = 0; c < C; ++c)
+				{
+					std::fill(rows[c], rows[c] + W, pad_value[c]);
+				}
+			}
+			else
+			{
+				int   y0, y1;
+				float wy;
+				computeTap(cy, inv_sy, src.height, y0, y1, wy);
+				const float *const *h0 = cache.get(y0, y1, src, stride, xtable, map);
+				const float *const *h1 = cache.get(y1, y0, src, stride, xtable, map);
+
+				for (int c = 0; c < C; ++c)
+				{
+					std::fill(rows[c], rows[c] + resize.pad_x, pad_value[c]);
+					std::fill(rows[c] + resize.pad_x + content_w, rows[c] + W, pad_value[c]);
+					blendRows(h0[c], h1[c], (1.0f - wy) * options.norm[c], wy * options.norm[c],
+					          -options.mean[c] * options.norm[c], rows[c] + resize.pad_x, content_w);
+				}
+			}
+
+			if (direct)
+			{
+				continue;
+			}
+
+			if (dst_desc.layout == MemoryLayout::kNCHW)
+			{
+				for (int c = 0; c < C; ++c)
+				{
+					storeRow(rows[c], dst_desc.data_type, out + (c * HW + y * W) * element_size, W);
+				}
+			}
+			else if (dst_desc.layout == MemoryLayout::kNHWC)
+			{
+				for (int x = 0; x < W; ++x)
+				{
+					for (int c = 0; c < C; ++c)
+					{
+						packed[x * C + c] = rows[c][x];
+					}
+				}
+				storeRow(packed.data(), dst_desc.data_type, out + y * W * C * element_size, static_cast<size_t>(W) * C);
+			}
+			else
+			{
+				for (int cb = 0; cb < (C + 3) / 4; ++cb)
+				{
+					for (int x = 0; x < W; ++x)
+					{
+						for (int k = 0; k < 4; ++k)
+						{
+							const int c       = cb * 4 + k;
+							packed[x * 4 + k] = c < C ? rows[c][x] : 0.0f;
+						}
+					}
+					storeRow(packed.data(), dst_desc.data_type, out + (cb * HW + y * W) * 4 * element_size,
+					         static_cast<size_t>(W) * 4);
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+bool preprocessImage(const ImageView &src, ITensor &dst, const PreprocessOptions &options, ResizeInfo *info)
+{
+	return preprocessImage(src, dst.desc(), dst.data(), options, info);
+}
+}        // namespace gomang
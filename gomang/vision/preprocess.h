@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "core/tensor.h"
+
+namespace gomang
+{
+enum class PixelFormat
+{
+	kRGB,
+	kBGR,
+	kRGBA,
+	kBGRA,
+	kGRAY
+};
+
+enum class ResizeMode
+{
+	kStretch,          // scale each axis independently to the tensor size
+	kLetterbox         // keep aspect ratio, centre and pad with pad_value
+};
+
+// Non-owning interleaved 8-bit image. stride is in bytes; 0 means tightly packed.
+struct ImageView
+{
+	const uint8_t *data{nullptr};
+	int            width{0};
+	int            height{0};
+	size_t         stride{0};
+	PixelFormat    format{PixelFormat::kBGR};
+};
+
+// Output value = (pixel - mean[c]) * norm[c], with c in the order of
+// dst_format, the same convention as MNN::CV::ImageProcess.
+struct PreprocessOptions
+{
+	ResizeMode           resize_mode{ResizeMode::kStretch};
+	PixelFormat          dst_format{PixelFormat::kRGB};
+	std::array<float, 4> mean{0.0f, 0.0f, 0.0f, 0.0f};
+	std::array<float, 4> norm{1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+	uint8_t              pad_value{114};
+	unsigned int         num_threads{1};
+};
+
+// Where the source image landed in the tensor, for mapping results back:
+// src_x = (dst_x - pad_x) / scale_x.
+struct ResizeInfo
+{
+	float scale_x{1.0f};
+	float scale_y{1.0f};
+	int   pad_x{0};
+	int   pad_y{0};
+};
+
+// Bilinear resize, colour conversion, normalization and packing in a single
+// pass over the output, written straight into one image of dst_desc (N is
+// ignored; offset dst for other batch entries). dst_desc may be kNCHW, kNHWC
+// or kNC4HW4 in kFLOAT32, kFLOAT16 or kBFLOAT16, and its channel count must
+// match dst_format. Rows are split across options.num_threads.
+bool preprocessImage(const ImageView &src, const TensorDesc &dst_desc, void *dst,
+                     const PreprocessOptions &options, ResizeInfo *info = nullptr);
+
+bool preprocessImage(const ImageView &src, ITensor &dst,
+                     const PreprocessOptions &options, ResizeInfo *info = nullptr);
+}        // namespace gomang
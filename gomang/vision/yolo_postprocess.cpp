@@ -0,0 +1,351 @@
+#include "yolo_postprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include "core/parallel.h"
+#include "core/precision.h"
+#include "core/trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#	define GOMANG_YOLO_X86 1
+#	include <immintrin.h>
+#endif
+
+namespace gomang
+{
+namespace
+{
+bool hasAvx2()
+{
+#ifdef GOMANG_YOLO_X86
+	static const bool has_avx2 = [] {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	}();
+	return has_avx2;
+#else
+	return false;
+#endif
+}
+
+float sigmoid(float x)
+{
+	return 1.0f / (1.0f + std::exp(-x));
+}
+
+// Threshold on the raw objectness value equivalent to score_threshold.
+float getObjectnessCutoff(const YoloOptions &options)
+{
+	const float t = options.score_threshold;
+	if (!options.apply_sigmoid)
+	{
+		return t;
+	}
+	if (t <= 0.0f)
+	{
+		return -std::numeric_limits<float>::infinity();
+	}
+	if (t >= 1.0f)
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+	return std::log(t / (1.0f - t));
+}
+
+int argmaxScalar(const float *values, int count)
+{
+	return static_cast<int>(std::max_element(values, values + count) - values);
+}
+
+#ifdef GOMANG_YOLO_X86
+__attribute__((target("avx2"))) int argmaxAvx2(const float *values, int count)
+{
+	if (count < 16)
+	{
+		return argmaxScalar(values, count);
+	}
+
+	__m256 vmax = _mm256_loadu_ps(values);
+	int    i    = 8;
+	for (; i + 8 <= count; i += 8)
+	{
+		vmax = _mm256_max_ps(vmax, _mm256_loadu_ps(values + i));
+	}
+	float lanes[8];
+	_mm256_storeu_ps(lanes, vmax);
+	float best = *std::max_element(lanes, lanes + 8);
+	for (; i < count; ++i)
+	{
+		best = std::max(best, values[i]);
+	}
+
+	// First index holding the maximum, matching std::max_element.
+	const __m256 vbest = _mm256_set1_ps(best);
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), vbest, _CMP_EQ_OQ));
+		if (mask)
+		{
+			return i + __builtin_ctz(mask);
+		}
+	}
+	for (; i < count; ++i)
+	{
+		if (values[i] == best)
+		{
+			return i;
+		}
+	}
+	return 0;
+}
+
+// Objectness sits at a fixed stride, so eight rows are tested per gather and
+// only rows that pass are visited.
+template <typename Visit>
+__attribute__((target("avx2"))) int filterRowsAvx2(const float *rows, int num_boxes, int stride, float cutoff, Visit &&visit)
+{
+	const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+	const __m256  vcutoff = _mm256_set1_ps(cutoff);
+
+	int i = 0;
+	for (; i + 8 <= num_boxes; i += 8)
+	{
+		__m256 obj  = _mm256_i32gather_ps(rows + static_cast<size_t>(i) * stride + 4, offsets, 4);
+		int    mask = _mm256_movemask_ps(_mm256_cmp_ps(obj, vcutoff, _CMP_GE_OQ));
+		while (mask)
+		{
+			visit(i + __builtin_ctz(mask));
+			mask &= mask - 1;
+		}
+	}
+	return i;
+}
+#endif
+
+int argmax(const float *values, int count)
+{
+#ifdef GOMANG_YOLO_X86
+	if (hasAvx2())
+	{
+		return argmaxAvx2(values, count);
+	}
+#endif
+	return argmaxScalar(values, count);
+}
+
+// Corner boxes overlap by more than threshold, without a division.
+bool overlaps(const Detection &a, float area_a, const Detection &b, float area_b, float threshold)
+{
+	const float w = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+	if (w <= 0.0f)
+	{
+		return false;
+	}
+	const float h = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+	if (h <= 0.0f)
+	{
+		return false;
+	}
+	const float inter = w * h;
+	return inter > threshold * (area_a + area_b - inter);
+}
+
+float getArea(const Detection &d)
+{
+	return std::max(0.0f, d.x2 - d.x1) * std::max(0.0f, d.y2 - d.y1);
+}
+
+// Greedy NMS over [begin, end), already sorted by score, appending survivors.
+void suppressGroup(const Detection *begin, const Detection *end, float iou_threshold, size_t max_keep,
+                   std::vector<Detection> &kept, std::vector<float> &kept_areas)
+{
+	const size_t first = kept.size();
+	for (const Detection *d = begin; d != end && kept.size() - first < max_keep; ++d)
+	{
+		const float area       = getArea(*d);
+		bool        suppressed = false;
+		for (size_t k = first; k < kept.size(); ++k)
+		{
+			if (overlaps(kept[k], kept_areas[k], *d, area, iou_threshold))
+			{
+				suppressed = true;
+				break;
+			}
+		}
+		if (!suppressed)
+		{
+			kept.push_back(*d);
+			kept_areas.push_back(area);
+		}
+	}
+}
+
+bool byScore(const Detection &a, const Detection &b)
+{
+	return a.score > b.score;
+}
+}        // namespace
+
+void decodeYoloV5(const float *rows, int num_boxes, int num_classes, const YoloOptions &options,
+                  std::vector<Detection> &candidates)
+{
+	GOMANG_TRACE_SCOPE("vision", "yolo_decode");
+
+	const int   stride = 5 + num_classes;
+	const float cutoff = getObjectnessCutoff(options);
+
+	auto visit = [&](int i) {
+		const float *row = rows + static_cast<size_t>(i) * stride;
+		const int    cls = num_classes > 0 ? argmax(row + 5, num_classes) : 0;
+
+		float obj   = row[4];
+		float score = num_classes > 0 ? row[5 + cls] : 1.0f;
+		if (options.apply_sigmoid)
+		{
+			obj   = sigmoid(obj);
+			score = num_classes > 0 ? sigmoid(score) : 1.0f;
+		}
+		score *= obj;
+		if (score < options.score_threshold)
+		{
+			return;
+		}
+
+		const float half_w = row[2] * 0.5f;
+		const float half_h = row[3] * 0.5f;
+		candidates.push_back({row[0] - half_w, row[1] - half_h, row[0] + half_w, row[1] + half_h, score, cls});
+	};
+
+	int i = 0;
+#ifdef GOMANG_YOLO_X86
+	if (hasAvx2())
+	{
+		i = filterRowsAvx2(rows, num_boxes, stride, cutoff, visit);
+	}
+#endif
+	for (; i < num_boxes; ++i)
+	{
+		if (rows[static_cast<size_t>(i) * stride + 4] >= cutoff)
+		{
+			visit(i);
+		}
+	}
+}
+
+void nonMaxSuppression(std::vector<Detection> &detections, float iou_threshold, int max_detections,
+                       bool class_agnostic)
+{
+	GOMANG_TRACE_SCOPE("vision", "nms");
+
+	const auto max_keep = static_cast<size_t>(std::max(max_detections, 0));
+	std::sort(detections.begin(), detections.end(), byScore);
+
+	std::vector<Detection> kept;
+	std::vector<float>     kept_areas;
+	kept.reserve(std::min(detections.size(), max_keep));
+	kept_areas.reserve(kept.capacity());
+
+	if (class_agnostic)
+	{
+		suppressGroup(detections.data(), detections.data() + detections.size(), iou_threshold, max_keep, kept, kept_areas);
+	}
+	else
+	{
+		// Bucket by class, keeping score order inside each bucket, so boxes are
+		// only compared against boxes of their own class.
+		std::stable_sort(detections.begin(), detections.end(),
+		                 [](const Detection &a, const Detection &b) { return a.class_id < b.class_id; });
+		auto *begin = detections.data();
+		auto *end   = detections.data() + detections.size();
+		while (begin != end)
+		{
+			auto *group_end = std::find_if(begin, end, [&](const Detection &d) { return d.class_id != begin->class_id; });
+			suppressGroup(begin, group_end, iou_threshold, max_keep, kept, kept_areas);
+			begin = group_end;
+		}
+		std::sort(kept.begin(), kept.end(), byScore);
+	}
+
+	if (kept.size() > max_keep)
+	{
+		kept.resize(max_keep);
+	}
+	detections = std::move(kept);
+}
+
+bool postprocessYoloV5(const float *output, int batch, int num_boxes, int num_classes, const YoloOptions &options,
+                       std::vector<std::vector<Detection>> &results, unsigned int num_threads)
+{
+	if (!output || batch <= 0 || num_boxes < 0 || num_classes < 0)
+	{
+		std::cerr << "postprocessYoloV5: invalid output tensor" << std::endl;
+		return false;
+	}
+
+	results.assign(batch, {});
+	const size_t image_size = static_cast<size_t>(num_boxes) * (5 + num_classes);
+	parallelFor(0, batch, num_threads, 1, [&](size_t begin, size_t end) {
+		for (size_t b = begin; b < end; ++b)
+		{
+			auto &detections = results[b];
+			decodeYoloV5(output + b * image_size, num_boxes, num_classes, options, detections);
+
+			// Early cut before the quadratic part; a crowded frame can pass tens of
+			// thousands of low-confidence boxes.
+			const auto max_candidates = static_cast<size_t>(std::max(options.max_candidates, 0));
+			if (detections.size() > max_candidates)
+			{
+				std::nth_element(detections.begin(), detections.begin() + max_candidates, detections.end(), byScore);
+				detections.resize(max_candidates);
+			}
+
+			nonMaxSuppression(detections, options.iou_threshold, options.max_detections, options.class_agnostic);
+		}
+	});
+	return true;
+}
+
+bool postprocessYoloV5(const ITensor &output, const YoloOptions &options,
+                       std::vector<std::vector<Detection>> &results, unsigned int num_threads)
+{
+	const auto &desc = output.desc();
+	if (desc.shape.size() != 3 || desc.shape[2] < 5)
+	{
+		std::cerr << "postprocessYoloV5: expected a [N, boxes, 5 + classes] tensor" << std::endl;
+		return false;
+	}
+
+	const auto batch       = static_cast<int>(desc.shape[0]);
+	const auto num_boxes   = static_cast<int>(desc.shape[1]);
+	const auto num_classes = static_cast<int>(desc.shape[2] - 5);
+
+	if (desc.data_type == DataType::kFLOAT32)
+	{
+		return postprocessYoloV5(static_cast<const float *>(output.data()), batch, num_boxes, num_classes, options,
+		                         results, num_threads);
+	}
+
+	std::vector<float> widened(desc.getElementsCount());
+	if (!convertDataType(output.data(), desc.data_type, widened.data(), DataType::kFLOAT32, widened.size(), num_threads))
+	{
+		return false;
+	}
+	return postprocessYoloV5(widened.data(), batch, num_boxes, num_classes, options, results, num_threads);
+}
+
+void mapToSource(std::vector<Detection> &detections, const ResizeInfo &info, int src_width, int src_height)
+{
+	const auto max_x = static_cast<float>(src_width);
+	const auto max_y = static_cast<float>(src_height);
+	for (auto &d : detections)
+	{
+		d.x1 = std::clamp((d.x1 - info.pad_x) / info.scale_x, 0.0f, max_x);
+		d.y1 = std::clamp((d.y1 - info.pad_y) / info.scale_y, 0.0f, max_y);
+		d.x2 = std::clamp((d.x2 - info.pad_x) / info.scale_x, 0.0f, max_x);
+		d.y2 = std::clamp((d.y2 - info.pad_y) / info.scale_y, 0.0f, max_y);
+	}
+}
+}        // namespace gomang
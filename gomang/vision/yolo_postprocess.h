@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "core/tensor.h"
+#include "preprocess.h"
+
+namespace gomang
+{
+// Corner-form box in the coordinates of the network input.
+struct Detection
+{
+	float x1{0.0f};
+	float y1{0.0f};
+	float x2{0.0f};
+	float y2{0.0f};
+	float score{0.0f};
+	int   class_id{0};
+};
+
+struct YoloOptions
+{
+	float score_threshold{0.25f};
+	float iou_threshold{0.45f};
+	int   max_detections{300};
+	int   max_candidates{30000};        // highest-scoring boxes kept for NMS
+	bool  apply_sigmoid{false};         // head emits logits rather than probabilities
+	bool  class_agnostic{false};
+};
+
+// Decodes one image of a YOLOv5 head laid out as num_boxes rows of
+// [cx, cy, w, h, objectness, class scores...]. Rows are rejected on
+// objectness first (in logit space when apply_sigmoid is set, so rejected
+// rows never evaluate a sigmoid); survivors take their best class and are
+// kept if objectness * class score reaches score_threshold.
+void decodeYoloV5(const float *rows, int num_boxes, int num_classes, const YoloOptions &options,
+                  std::vector<Detection> &candidates);
+
+// Greedy NMS, per class unless class_agnostic. Leaves at most max_detections
+// boxes sorted by descending score.
+void nonMaxSuppression(std::vector<Detection> &detections, float iou_threshold, int max_detections,
+                       bool class_agnostic = false);
+
+// Decode + NMS for a batch of images, one image per task.
+bool postprocessYoloV5(const float *output, int batch, int num_boxes, int num_classes, const YoloOptions &options,
+                       std::vector<std::vector<Detection>> &results, unsigned int num_threads = 1);
+
+// Same, taking batch, box and class counts from a [N, boxes, 5 + classes]
+// output tensor. FP16/BF16 outputs are widened first.
+bool postprocessYoloV5(const ITensor &output, const YoloOptions &options,
+                       std::vector<std::vector<Detection>> &results, unsigned int num_threads = 1);
+
+// Undoes the resize/letterbox from preprocessImage() and clamps to the source image.
+void mapToSource(std::vector<Detection> &detections, const ResizeInfo &info, int src_width, int src_height);
+}        // namespace gomang